@@ -1,5 +1,154 @@
+#include "Arduino.h"
 
 #include "Application.hpp"
 
 
-Application Application::sInstance;
+/*
+ * Every EventObject connects to the application from its constructor, so
+ * objects in static storage need it constructed before their own
+ * translation unit's initialisers run.
+ */
+Application Application::sInstance __attribute__((init_priority(101)));
+
+
+Application::Application()
+    : EventObject(),
+    mIterationStart(0),
+    mIterationBudget(5000)
+{
+    for (unsigned char i = 0; i < EventEmitter::PrioritiesCount; i++) {
+        mPosted[i].head = nullptr;
+        mPosted[i].tail = nullptr;
+        mDispatched[i].head = nullptr;
+        mDispatched[i].tail = nullptr;
+    }
+}
+
+
+/*
+ * Emit what was posted before this call, high priority first. Emitters
+ * posted meanwhile wait for the next iteration, as do low priority ones
+ * once the iteration budget is spent. At least one low priority emitter
+ * runs per iteration, so an overrun elsewhere cannot starve them.
+ */
+void Application::dispatch()
+{
+    for (unsigned char i = 0; i < EventEmitter::PrioritiesCount; i++) {
+        mDispatched[i] = mPosted[i];
+        mPosted[i].head = nullptr;
+        mPosted[i].tail = nullptr;
+    }
+
+    for (unsigned char i = 0; i < EventEmitter::PrioritiesCount; i++) {
+        PostQueue &queue = mDispatched[i];
+        bool first = true;
+
+        while (queue.head != nullptr) {
+            if (i == EventEmitter::Low && !first &&
+                    mIterationStart.elapsed() >= mIterationBudget) {
+
+                /* Put the remainder back in front of the live queue */
+                PostQueue &live = mPosted[i];
+
+                queue.tail->mNextPosted = live.head;
+                live.head = queue.head;
+
+                if (live.tail == nullptr) {
+                    live.tail = queue.tail;
+                }
+
+                queue.head = nullptr;
+                queue.tail = nullptr;
+
+                break;
+            }
+
+            EventEmitter *emitter = queue.head;
+
+            queue.head = emitter->mNextPosted;
+
+            if (queue.head == nullptr) {
+                queue.tail = nullptr;
+            }
+
+            emitter->mNextPosted = nullptr;
+            emitter->mPosted = false;
+            emitter->emit();
+
+            first = false;
+        }
+    }
+}
+
+
+void Application::exec()
+{
+    mIterationStart = Timestamp<MicrosClock>::now();
+
+    loop()->emit();
+    loopPost()->emit();
+    dispatch();
+}
+
+
+/* Posting an emitter that is already queued coalesces into one emission */
+void Application::post(EventEmitter *emitter)
+{
+    if (emitter->mPosted) {
+        return;
+    }
+
+    PostQueue &queue = mPosted[emitter->mPriority];
+
+    emitter->mPosted = true;
+    emitter->mNextPosted = nullptr;
+
+    if (queue.tail == nullptr) {
+        queue.head = emitter;
+    } else {
+        queue.tail->mNextPosted = emitter;
+    }
+
+    queue.tail = emitter;
+}
+
+
+/* Forget a posted emitter, from ~EventEmitter() */
+void Application::unpost(EventEmitter *emitter)
+{
+    /* Every queue: its priority may have changed since it was posted */
+    for (unsigned char i = 0; i < EventEmitter::PrioritiesCount; i++) {
+        unlink(mPosted[i], emitter);
+        unlink(mDispatched[i], emitter);
+    }
+
+    emitter->mNextPosted = nullptr;
+    emitter->mPosted = false;
+}
+
+
+void Application::unlink(PostQueue &queue, EventEmitter *emitter)
+{
+    EventEmitter *previous = nullptr;
+
+    for (EventEmitter *node = queue.head;
+            node != nullptr;
+            node = node->mNextPosted) {
+
+        if (node == emitter) {
+            if (previous == nullptr) {
+                queue.head = node->mNextPosted;
+            } else {
+                previous->mNextPosted = node->mNextPosted;
+            }
+
+            if (queue.tail == node) {
+                queue.tail = previous;
+            }
+
+            return;
+        }
+
+        previous = node;
+    }
+}
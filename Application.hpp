@@ -1,8 +1,8 @@
-
 #pragma once
 
 
 #include "EventObject.hpp"
+#include "Time.hpp"
 
 
 class Application : public EventObject
@@ -16,6 +16,29 @@ class Application : public EventObject
     static Application sInstance;
 
 
+    struct PostQueue
+    {
+        EventEmitter *head;
+        EventEmitter *tail;
+    };
+
+
+    PostQueue mPosted[EventEmitter::PrioritiesCount];
+
+    /* What dispatch() took from mPosted and has not emitted yet */
+    PostQueue mDispatched[EventEmitter::PrioritiesCount];
+
+    Timestamp<MicrosClock> mIterationStart;
+    Duration<MicrosClock> mIterationBudget;
+
+
+    explicit Application();
+
+    void dispatch();
+
+    static void unlink(PostQueue &queue, EventEmitter *emitter);
+
+
 public:
 
     inline static Application *instance()
@@ -23,4 +46,31 @@ public:
         return &sInstance;
     }
 
+
+    void exec();
+    void post(EventEmitter *emitter);
+    void unpost(EventEmitter *emitter);
+
+
+    /*
+     * Low priority emitters only run while the iteration is younger than
+     * this, past the first one; the rest waits for the next iteration.
+     */
+    inline Duration<MicrosClock> iterationBudget() const
+    {
+        return mIterationBudget;
+    }
+
+
+    inline void setIterationBudget(Duration<MicrosClock> value)
+    {
+        mIterationBudget = value;
+    }
+
+
+    inline Timestamp<MicrosClock> iterationStart() const
+    {
+        return mIterationStart;
+    }
+
 };
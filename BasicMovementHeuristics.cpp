@@ -1,30 +1,40 @@
 
+#include <float.h>
 #include <math.h>
 
 #include "BasicMovementHeuristics.hpp"
 
 
+/*
+ * Steer (y, positive to the left) away from the nearer side once the
+ * sides differ by more than the body and the sensor noise, and drive
+ * (x) in proportion to the room ahead.
+ */
 void BasicMovementHeuristics::eval()
 {
-    const float maxX = 0.5;
-    float diff = mSensors->frontRight() - mSensors->frontLeft();
+    const float maxY = 0.5;
+    float diff = mSensors->frontLeft() - mSensors->frontRight();
     float minDiff = mSensors->maxDelta() * 2 + mSensors->width();
     Vector2f direction;
 
     if (fabs(diff) > minDiff && !isnan(diff)) {
-        diff -= minDiff;
+        diff -= copysign(minDiff, diff);
 
         if (isinf(diff)) {
-            direction.setX(maxX * (signbit(diff) * -2 + 1));
+            direction.setY(maxY * (signbit(diff) * -2 + 1));
         } else {
-            direction.setX(maxX * diff / mSensors->maximum());
+            direction.setY(fmax(-maxY, fmin(maxY,
+                        maxY * diff / mSensors->maximum())));
         }
     }
 
+    /* One ulp under the unit circle, which sqrt() may round up to */
+
     float front = mSensors->front();
-    float maxY = sqrt(1 - direction.x() * direction.x());
+    float maxX = sqrt(1 - direction.y() * direction.y()) * (1 - FLT_EPSILON);
 
-    direction.setY(isinf(front) ? maxY : front * maxY / mSensors->maximum());
+    direction.setX(isinf(front) ? maxX :
+            fmin(maxX, front * maxX / mSensors->maximum()));
 
     mMovementController->setDirection(direction);
 }
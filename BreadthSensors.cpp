@@ -1,42 +1,79 @@
+#include <math.h>
 
 #include "Application.hpp"
 
 #include "BreadthSensors.hpp"
 
 
-#define BREADTH_SENSOR(name, camelPart, mask)  \
-    void BreadthSensors::name##InitFailed()            \
-    {                                                  \
-        m##camelPart->reinit();                        \
-    }                                                  \
-                                                       \
-                                                       \
-    void BreadthSensors::name##InitFinished()          \
-    {                                                  \
-        mSensors |= mask;                              \
-        m##camelPart->start();                         \
-    }                                                  \
-                                                       \
-                                                       \
-    void BreadthSensors::name##RangeError()            \
-    {                                                  \
-        mSensors &= ~(mask);                           \
-        m##camelPart->reinit();                        \
-    }                                                  \
-                                                       \
-                                                       \
-    void BreadthSensors::name##RangeReady()            \
-    {                                                  \
-        mReadySensors |= mask;                         \
-                                                       \
-        if (mReadySensors & mSensors == mSensors) {    \
-            ready()->emit();                           \
-            mReadySensors = 0;                         \
-        }                                              \
-    }
-
-
-BREADTH_SENSORS;
+/*
+ * Every sensor shares the four slots below. setSensor() tags the sensor's
+ * emitters with its index, which the slots read back through
+ * EventEmitter::sender().
+ */
+unsigned char BreadthSensors::senderIndex() const
+{
+    unsigned char index = EventEmitter::sender()->tag();
+
+    debugAssert(index < mCount && mSensors[index] != nullptr);
+
+    return index;
+}
+
+
+void BreadthSensors::onInitFailed()
+{
+    mSensors[senderIndex()]->reinit();
+}
+
+
+void BreadthSensors::onInitFinished()
+{
+    unsigned char index = senderIndex();
+    RangeSensor *sensor = mSensors[index];
+
+    /* start() powers a sensor switched off during its init right down */
+
+    if (sensor->power() != RangeSensor::PowerOff) {
+        mStartedSensors |= 1 << index;
+    }
+
+    if (sensor->power() == RangeSensor::PowerActive) {
+        mActiveSensors |= 1 << index;
+    }
+
+    sensor->start();
+}
+
+
+void BreadthSensors::onRangeError()
+{
+    unsigned char index = senderIndex();
+    unsigned char mask = ~(1 << index);
+
+    mStartedSensors &= mask;
+    mActiveSensors &= mask;
+    mReadySensors &= mask;
+    mSensors[index]->reinit();
+}
+
+
+void BreadthSensors::onRangeReady()
+{
+    unsigned char bit = 1 << senderIndex();
+
+    /* Idle samples only update their slot; with no active sensor, no ready */
+
+    if (!(mActiveSensors & bit)) {
+        return;
+    }
+
+    mReadySensors |= bit;
+
+    if ((mReadySensors & mActiveSensors) == mActiveSensors) {
+        mReadySensors = 0;
+        ready()->emit();
+    }
+}
 
 
 BreadthSensors::BreadthSensors(float width, float length)
@@ -45,8 +82,111 @@ BreadthSensors::BreadthSensors(float width, float length)
     mLength(length),
     mMaxDelta(0),
     mMaximum(0),
-    mSensors(0),
+    mCount(0),
+    mStartedSensors(0),
+    mActiveSensors(0),
     mReadySensors(0)
 {
+    for (unsigned char i = 0; i < Capacity; i++) {
+        RangeSample &sample = mSamples[i];
+
+        mSensors[i] = nullptr;
+
+        sample.distance = INFINITY;
+        sample.time = 0;
+        sample.range = -1;
+        sample.status = RangeSensor::RangeNone;
+    }
+}
+
 
+void BreadthSensors::setSensor(unsigned char index, RangeSensor *sensor)
+{
+    debugAssert(index < Capacity && mSensors[index] == nullptr);
+
+    sensor->initFailed()->setTag(index);
+    sensor->initFinished()->setTag(index);
+    sensor->rangeError()->setTag(index);
+    sensor->rangeReady()->setTag(index);
+
+    EventObjectConnect(sensor, initFailed, this, onInitFailed);
+    EventObjectConnect(sensor, initFinished, this, onInitFinished);
+    EventObjectConnect(sensor, rangeError, this, onRangeError);
+    EventObjectConnect(sensor, rangeReady, this, onRangeReady);
+
+    sensor->setSample(&mSamples[index]);
+    mSensors[index] = sensor;
+
+    if (index >= mCount) {
+        mCount = index + 1;
+    }
+
+    updateLimits();
+}
+
+
+void BreadthSensors::updateLimits()
+{
+    mMaxDelta = 0;
+    mMaximum = 0;
+
+    for (unsigned char i = 0; i < mCount; i++) {
+        RangeSensor *sensor = mSensors[i];
+
+        if (sensor == nullptr) {
+            continue;
+        }
+
+        float delta = sensor->delta();
+
+        if (delta > mMaxDelta) {
+            mMaxDelta = delta;
+        }
+
+        float maximum = sensor->maximum();
+
+        if (maximum > mMaximum) {
+            mMaximum = maximum;
+        }
+    }
+}
+
+
+void BreadthSensors::setPower(unsigned char index, unsigned char power)
+{
+    debugAssert(index < mCount && mSensors[index] != nullptr);
+
+    RangeSensor *sensor = mSensors[index];
+    unsigned char bit = 1 << index;
+
+    unsigned char previous = sensor->power();
+
+    /* The sensor may degrade the level, PowerOff without an XSHUT pin */
+
+    sensor->setPower(power);
+    power = sensor->power();
+
+    if (power == previous) {
+        return;
+    }
+
+    /* Coming back from PowerOff takes a re-init and its initFinished */
+
+    if (power == RangeSensor::PowerOff) {
+        mStartedSensors &= ~bit;
+    }
+
+    if (power == RangeSensor::PowerActive && (mStartedSensors & bit)) {
+        mActiveSensors |= bit;
+    } else {
+        mActiveSensors &= ~bit;
+        mReadySensors &= ~bit;
+    }
+
+    if (power < RangeSensor::PowerIdle) {
+
+        /* Resets the slot to no sample */
+
+        sensor->setSample(&mSamples[index]);
+    }
 }
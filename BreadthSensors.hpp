@@ -1,94 +1,126 @@
-
 #pragma once
 
 
-#include <math.h>
-
 #include "EventObject.hpp"
 #include "RangeSensor.hpp"
 #include "Debug.hpp"
 
 
-#define BREADTH_SENSOR(name, camelPart, mask)                          \
-    EVENT_OBJECT_SLOT(BreadthSensors, name##InitFailed);                       \
-    EVENT_OBJECT_SLOT(BreadthSensors, name##InitFinished);                     \
-    EVENT_OBJECT_SLOT(BreadthSensors, name##RangeError);                       \
-    EVENT_OBJECT_SLOT(BreadthSensors, name##RangeReady);                       \
-                                                                               \
-                                                                               \
-    private:                                                                   \
-                                                                               \
-        RangeSensor *m##camelPart;                                             \
-                                                                               \
-                                                                               \
-    public:                                                                    \
-                                                                               \
-        inline void set##camelPart(RangeSensor *value) {                       \
-            EventObjectConnect(value, initFailed, this, name##InitFailed);     \
-            EventObjectConnect(value, initFinished, this, name##InitFinished); \
-            EventObjectConnect(value, rangeError, this, name##RangeError);     \
-            EventObjectConnect(value, rangeReady, this, name##RangeReady);     \
-                                                                               \
-            float delta = value->delta();                                      \
-                                                                               \
-            if (delta > mMaxDelta) {                                           \
-                mMaxDelta = delta;                                             \
-            }                                                                  \
-                                                                               \
-            float maximum = value->maximum();                                  \
-                                                                               \
-            if (maximum > mMaximum) {                                          \
-                mMaximum = maximum;                                            \
-            }                                                                  \
-                                                                               \
-            m##camelPart = value;                                              \
-        }                                                                      \
-                                                                               \
-                                                                               \
-        inline float name() const                                              \
-        {                                                                      \
-            debugAssert(mReadySensors & mSensors == mSensors);                 \
-                                                                               \
-            if (m##camelPart->range() == -1) {                                 \
-                return INFINITY;                                               \
-            }                                                                  \
-                                                                               \
-            return (float) m##camelPart->range();                              \
-        }
-
-
-#define BREADTH_SENSORS                         \
-    BREADTH_SENSOR(front, Front, 1);            \
-    BREADTH_SENSOR(frontLeft, FrontLeft, 2);    \
-    BREADTH_SENSOR(frontRight, FrontRight, 4);  
-/*
-    BREADTH_SENSOR(rearLeft, RearLeft, 8);      \
-    BREADTH_SENSOR(rearRight, RearRight, 16);
-    */
-
-
 class BreadthSensors : public EventObject
 {
 
     EVENT_OBJECT_SIGNAL(BreadthSensors, ready);
 
-    BREADTH_SENSORS;
+    EVENT_OBJECT_SLOT(BreadthSensors, onInitFailed);
+    EVENT_OBJECT_SLOT(BreadthSensors, onInitFinished);
+    EVENT_OBJECT_SLOT(BreadthSensors, onRangeError);
+    EVENT_OBJECT_SLOT(BreadthSensors, onRangeReady);
+
+
+public:
+
+    /* Bounded by the width of the ready masks */
+    static const unsigned char Capacity = 8;
 
 
+    enum Position
+    {
+        Front,
+        FrontLeft,
+        FrontRight,
+        RearLeft,
+        RearRight
+    };
+
+
+private:
+
+    RangeSensor *mSensors[Capacity];
+
+    /* Written in place by the sensors, see RangeSensor::setSample() */
+    RangeSample mSamples[Capacity];
+
     const float mWidth;
     const float mLength;
 
     float mMaxDelta;
     float mMaximum;
 
-    unsigned char mSensors;
+    unsigned char mCount;
+
+    /* Initialised and started; a subset of these gates ready */
+    unsigned char mStartedSensors;
+    unsigned char mActiveSensors;
     unsigned char mReadySensors;
 
 
+    unsigned char senderIndex() const;
+
+
 public:
 
     explicit BreadthSensors(float width, float length);
 
+    void setSensor(unsigned char index, RangeSensor *sensor);
+
+    /*
+     * Move a sensor to a RangeSensor::Power level. Only PowerActive
+     * sensors gate ready; an idle sensor updates its slot whenever it has
+     * a sample, and the slot of a stopped sensor reads as no sample.
+     */
+    void setPower(unsigned char index, unsigned char power);
+
+    /* Refresh maxDelta() and maximum() after a sensor changed its own */
+    void updateLimits();
+
+
+    inline RangeSensor *sensor(unsigned char index) const
+    {
+        return mSensors[index];
+    }
+
+
+    /*
+     * No sample yet, from a sensor still initialising or stopped, reads as
+     * blocked: INFINITY would be taken for open space.
+     */
+    inline float distance(unsigned char index) const
+    {
+        return mSamples[index].status == RangeSensor::RangeNone ?
+            0 : mSamples[index].distance;
+    }
+
+
+    inline float front() const
+    {
+        return distance(Front);
+    }
+
+
+    inline float frontLeft() const
+    {
+        return distance(FrontLeft);
+    }
+
+
+    inline float frontRight() const
+    {
+        return distance(FrontRight);
+    }
+
+
+    inline float rearLeft() const
+    {
+        return distance(RearLeft);
+    }
+
+
+    inline float rearRight() const
+    {
+        return distance(RearRight);
+    }
+
+
     inline float width() const
     {
         return mWidth;
@@ -113,7 +145,18 @@ public:
     }
 
 
-};
+    /* Return the latest sample of every sensor slot, indexed by position */
+    inline const RangeSample *samples() const
+    {
+        return mSamples;
+    }
 
 
-#undef BREADTH_SENSOR
+    /* Return one past the highest occupied sensor slot */
+    inline unsigned char samplesCount() const
+    {
+        return mCount;
+    }
+
+
+};
@@ -1,6 +1,12 @@
 
 #include "Arduino.h"
 
+#ifdef __AVR__
+#    include <avr/wdt.h>
+#endif
+
+#include "Trace.hpp"
+
 #include "Debug.hpp"
 
 
@@ -15,9 +21,26 @@ void Debug::disableAll()
 }
 
 
+/*
+ * Stay in the panic loop: a watchdog reset would restart the robot and
+ * lose the message, and a persistent fault would become a reboot loop
+ */
+static void stopWatchdog()
+{
+#ifdef __AVR__
+    wdt_disable();
+#endif
+}
+
+
 void Debug::panic()
 {
     disableAll();
+    stopWatchdog();
+
+    Trace::freeze();
+    Trace::dump(Serial);
+
     pinMode(LED_BUILTIN, OUTPUT);
 
     for (bool state = LOW ;; state = !state) {
@@ -33,6 +56,10 @@ void Debug::panic(const char *file, int line, const char *message)
     bool state = LOW;
 
     disableAll();
+    stopWatchdog();
+
+    Trace::freeze();
+    Trace::dump(Serial);
 
     if (Serial) {
         Serial.end();
@@ -68,11 +68,10 @@
 class Debug
 {
 
-    static void disableAll();
-
 
 public:
 
+    static void disableAll();
     static void panic();
     static void panic(const char *file, int line, const char *message);
 
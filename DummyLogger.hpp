@@ -41,10 +41,12 @@ public:
     }
 
 
+#if LOGGER_HAS_SIZE_T
     inline Logger & operator<<(size_t value) override
     {
 
     }
+#endif
 
 
     inline Logger & operator<<(const char *value) override
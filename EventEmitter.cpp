@@ -2,74 +2,300 @@
 #include "Arduino.h"
 
 #include "Debug.hpp"
+#include "Memory.hpp"
+#include "Trace.hpp"
+#include "Watchdog.hpp"
 #include "Application.hpp"
 
 #include "EventEmitter.hpp"
 
 
-EventEmitter::EventEmitter()
-    : mLastEmitted(-1),
-    mEmitting(false)
+EventEmitter *EventEmitter::sSender = nullptr;
+
+EventEmitter::Node *EventEmitter::sIndex[EventEmitter::IndexSize];
+unsigned int EventEmitter::sIndexCount = 0;
+unsigned int EventEmitter::sUnindexedCount = 0;
+
+
+unsigned int EventEmitter::hash(const EventEmitter *emitter,
+        const EventObject *receiver, Slot slot)
 {
+    uint32_t key = (uint32_t) (uintptr_t) emitter ^
+        (uint32_t) (uintptr_t) receiver * 3 ^
+        (uint32_t) (uintptr_t) slot * 5;
+    uint16_t folded = key ^ key >> 16;
+
+    /* Fibonacci hashing: the top bits of the product mix best */
+    return (uint16_t) (folded * 40503U) >> (16 - EVENT_EMITTER_INDEX_BITS);
 }
 
 
-void EventEmitter::connect(EventObject *receiver, Slot slot)
+/* Index of the connection, or of the empty entry where it would go */
+unsigned int EventEmitter::find(const EventEmitter *emitter,
+        const EventObject *receiver, Slot slot)
 {
-    ReceiverSlot receiverSlot(receiver, slot);
+    unsigned int index = hash(emitter, receiver, slot);
 
-    if (!mReceivers.has(receiverSlot)) {
-        mReceivers.insert(receiverSlot);
-    } else {
-        debugWarn();
+    for (;;) {
+        const Node *node = sIndex[index];
+
+        if (node == nullptr || (node->value.emitter == emitter &&
+                    node->value.receiver == receiver &&
+                    node->value.slot == slot)) {
+            return index;
+        }
+
+        index = (index + 1) & (IndexSize - 1);
     }
 }
 
 
-void EventEmitter::disconnect(EventObject *receiver, Slot slot)
+/* Backward shift deletion: linear probing needs no tombstones */
+void EventEmitter::unindex(unsigned int index)
 {
-    mReceivers.remove(ReceiverSlot(receiver, slot), false);
+    unsigned int hole = index;
+    unsigned int next = index;
+
+    sIndex[hole] = nullptr;
+    sIndexCount--;
+
+    for (;;) {
+        next = (next + 1) & (IndexSize - 1);
+
+        Node *node = sIndex[next];
+
+        if (node == nullptr) {
+            return;
+        }
+
+        unsigned int home = hash(node->value.emitter, node->value.receiver,
+                node->value.slot);
+
+        /* Move it into the hole unless it would pass its home */
+
+        if (((next - home) & (IndexSize - 1)) >=
+                ((next - hole) & (IndexSize - 1))) {
+            sIndex[hole] = node;
+            sIndex[next] = nullptr;
+            hole = next;
+        }
+    }
 }
 
 
-void EventEmitter::once(EventObject *receiver, Slot slot)
+/* Live connection of this emitter, indexed or not */
+EventEmitter::Node *EventEmitter::lookup(const EventObject *receiver,
+        Slot slot)
 {
-    ReceiverSlot receiverSlot(receiver, slot, true);
+    Node *node = sIndex[find(this, receiver, slot)];
+
+    if (node != nullptr || sUnindexedCount == 0) {
+        return node;
+    }
 
-    if (!mReceivers.has(receiverSlot)) {
-        mReceivers.insert(receiverSlot);
+    for (node = mReceivers.head()->next;
+            node != mReceivers.head();
+            node = node->next) {
+
+        if (!node->value.dead && !node->value.indexed &&
+                node->value.receiver == receiver &&
+                node->value.slot == slot) {
+            return node;
+        }
+    }
+
+    return nullptr;
+}
+
+
+void EventEmitter::unindex(Node *node)
+{
+    if (node->value.indexed) {
+        unindex(find(this, node->value.receiver, node->value.slot));
     } else {
+        sUnindexedCount--;
+    }
+}
+
+
+EventEmitter::EventEmitter()
+    : mTag(0),
+    mDepth(0),
+    mNextPosted(nullptr),
+    mDead(false),
+    mEmitted(false),
+    mPosted(false),
+    mPriority(Normal)
+{
+}
+
+
+EventEmitter::~EventEmitter()
+{
+    if (mPosted) {
+        Application::instance()->unpost(this);
+    }
+
+    for (Node *node = mReceivers.head()->next;
+            node != mReceivers.head();
+            node = node->next) {
+
+        if (!node->value.dead) {
+            unindex(node);
+        }
+    }
+}
+
+
+void EventEmitter::add(EventObject *receiver, Slot slot, bool once)
+{
+    if (lookup(receiver, slot) != nullptr) {
         debugWarn();
+
+        return;
+    }
+
+    Memory::Scope scope(Memory::Events);
+
+    Node *node = mReceivers.insert(ReceiverSlot(receiver, slot, once, this));
+
+    /* Past three quarters linear probing degrades; keep to the list */
+
+    if (sIndexCount >= IndexSize / 4 * 3) {
+        sUnindexedCount++;
+
+        return;
+    }
+
+    node->value.indexed = true;
+    sIndex[find(this, receiver, slot)] = node;
+    sIndexCount++;
+}
+
+
+void EventEmitter::remove(Node *node)
+{
+    unindex(node);
+
+    if (mDepth != 0) {
+        node->value.dead = true;
+        mDead = true;
+
+        return;
+    }
+
+    Queue<ReceiverSlot>::unlink(node);
+    delete node;
+}
+
+
+void EventEmitter::sweep()
+{
+    Node *next;
+
+    for (Node *node = mReceivers.head()->next;
+            node != mReceivers.head();
+            node = next) {
+
+        next = node->next;
+
+        if (node->value.dead) {
+            Queue<ReceiverSlot>::unlink(node);
+            delete node;
+        }
     }
+
+    mDead = false;
+}
+
+
+void EventEmitter::connect(EventObject *receiver, Slot slot)
+{
+    add(receiver, slot, false);
+}
+
+
+void EventEmitter::disconnect(EventObject *receiver, Slot slot)
+{
+    if (receiver != nullptr && slot != nullptr) {
+        Node *node = lookup(receiver, slot);
+
+        if (node != nullptr) {
+            remove(node);
+        }
+
+        return;
+    }
+
+    ReceiverSlot pattern(receiver, slot);
+    Node *next;
+
+    for (Node *node = mReceivers.head()->next;
+            node != mReceivers.head();
+            node = next) {
+
+        next = node->next;
+
+        if (!node->value.dead && pattern == node->value) {
+            remove(node);
+        }
+    }
+}
+
+
+void EventEmitter::once(EventObject *receiver, Slot slot)
+{
+    add(receiver, slot, true);
 }
 
 
 void EventEmitter::emit()
 {
-    Queue<ReceiverSlot> receivers(mReceivers);
-    QueueNode<ReceiverSlot> *head = receivers.head();
+    Node *node = mReceivers.head();
+    Node *last = node->prev;
+    EventEmitter *sender = sSender;
+
+    mDepth++;
+    sSender = this;
 
-    mEmitting = true;
+    Trace::record(Trace::Emit, (uintptr_t) this);
+    Memory::sampleStack();
 
-    for (QueueNode<ReceiverSlot> *node = head->next;
-        node != head;
-        node = node->next) {
+    while (node != last) {
+        node = node->next;
 
         ReceiverSlot &receiverSlot = node->value;
 
+        if (receiverSlot.dead) {
+            continue;
+        }
+
         if (receiverSlot.once) {
-            mReceivers.remove(receiverSlot);
+            remove(node);
         }
 
+        Slot previous = Watchdog::enterSlot(receiverSlot.slot);
+        unsigned long start = micros();
+
+        Trace::record(Trace::SlotEnter, (uintptr_t) receiverSlot.slot);
         receiverSlot.slot(receiverSlot.receiver);
+        Trace::record(Trace::SlotExit, (uintptr_t) receiverSlot.slot);
+
+        Watchdog::exitSlot(previous, receiverSlot.slot, start);
     }
 
-    mLastEmitted = millis();
-    mEmitting = false;
+    sSender = sender;
+    mLastEmitted = Timestamp<MillisClock>::now();
+    mEmitted = true;
+
+    if (--mDepth == 0 && mDead) {
+        sweep();
+    }
 }
 
 
 void EventEmitter::post()
 {
-    EventObjectOnce(Application::instance(), loopPost, this, emit);
+    Trace::record(Trace::Post, (uintptr_t) this);
+    Application::instance()->post(this);
 }
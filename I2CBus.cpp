@@ -0,0 +1,119 @@
+#include "Arduino.h"
+
+#include <Wire.h>
+
+#include "I2CBus.hpp"
+
+
+#define I2C_BUS_HALF_PERIOD_US 5
+#define I2C_BUS_TIMEOUT_US 3000
+
+
+const uint32_t I2CBus::FastModeClock = 400000;
+
+
+uint32_t I2CBus::sClock = I2CBus::FastModeClock;
+unsigned long I2CBus::sRecoveries = 0;
+
+
+void I2CBus::Stats::record(unsigned char status)
+{
+    mTransactions++;
+    mLastStatus = status;
+
+    switch (status) {
+    case Success:
+        return;
+
+    case AddressNack:
+    case DataNack:
+        mNacks++;
+        break;
+
+    case Timeout:
+        mTimeouts++;
+        break;
+
+    default:
+        mErrors++;
+        break;
+    }
+
+    mFailed = true;
+}
+
+
+void I2CBus::begin(uint32_t clock)
+{
+    sClock = clock;
+
+    Wire.begin();
+    Wire.setClock(clock);
+
+#ifdef WIRE_HAS_TIMEOUT
+    Wire.setWireTimeout(I2C_BUS_TIMEOUT_US, true);
+#endif
+}
+
+
+/*
+ * Free a bus held by a slave that lost sync mid-byte: clock SCL until the
+ * slave releases SDA (at most 9 clocks), then issue a STOP condition and
+ * bring the TWI peripheral back up. Lines are driven open-drain by
+ * switching between OUTPUT LOW and INPUT_PULLUP.
+ */
+bool I2CBus::recover()
+{
+    sRecoveries++;
+
+    Wire.end();
+
+    pinMode(SDA, INPUT_PULLUP);
+    pinMode(SCL, INPUT_PULLUP);
+    delayMicroseconds(I2C_BUS_HALF_PERIOD_US);
+
+    for (unsigned char i = 0; i < 9 && digitalRead(SDA) == LOW; i++) {
+        digitalWrite(SCL, LOW);
+        pinMode(SCL, OUTPUT);
+        delayMicroseconds(I2C_BUS_HALF_PERIOD_US);
+
+        pinMode(SCL, INPUT_PULLUP);
+        delayMicroseconds(I2C_BUS_HALF_PERIOD_US);
+    }
+
+    digitalWrite(SDA, LOW);
+    pinMode(SDA, OUTPUT);
+    delayMicroseconds(I2C_BUS_HALF_PERIOD_US);
+
+    pinMode(SDA, INPUT_PULLUP);
+    delayMicroseconds(I2C_BUS_HALF_PERIOD_US);
+
+    bool released = digitalRead(SDA) == HIGH && digitalRead(SCL) == HIGH;
+
+    begin(sClock);
+
+    return released;
+}
+
+
+/*
+ * Wire.requestFrom() only reports a byte count; classify a short read. The
+ * master acknowledges the data bytes of a read, so nothing at all means
+ * the address went unacknowledged and a partial read a bus error.
+ */
+unsigned char I2CBus::requestStatus(uint8_t requested, uint8_t received)
+{
+    if (received == requested) {
+        return Success;
+    }
+
+#ifdef WIRE_HAS_TIMEOUT
+    if (Wire.getWireTimeoutFlag()) {
+        Wire.clearWireTimeoutFlag();
+
+        return Timeout;
+    }
+#endif
+
+    return received == 0 ? AddressNack : OtherError;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+
+#include <stdint.h>
+
+
+class I2CBus
+{
+
+    static uint32_t sClock;
+    static unsigned long sRecoveries;
+
+
+public:
+
+    /* Values returned by Wire.endTransmission() */
+    enum Status
+    {
+        Success,
+        DataTooLong,
+        AddressNack,
+        DataNack,
+        OtherError,
+        Timeout
+    };
+
+
+    class Stats
+    {
+
+        unsigned long mTransactions;
+        unsigned long mNacks;
+        unsigned long mTimeouts;
+        unsigned long mErrors;
+
+        unsigned char mLastStatus;
+        bool mFailed;
+
+
+    public:
+
+        inline explicit Stats()
+            : mTransactions(0),
+            mNacks(0),
+            mTimeouts(0),
+            mErrors(0),
+            mLastStatus(Success),
+            mFailed(false)
+        {
+
+        }
+
+
+        void record(unsigned char status);
+
+
+        inline unsigned long transactions() const
+        {
+            return mTransactions;
+        }
+
+
+        inline unsigned long nacks() const
+        {
+            return mNacks;
+        }
+
+
+        inline unsigned long timeouts() const
+        {
+            return mTimeouts;
+        }
+
+
+        inline unsigned long errors() const
+        {
+            return mErrors;
+        }
+
+
+        inline unsigned char lastStatus() const
+        {
+            return mLastStatus;
+        }
+
+
+        /* Return whether any transaction failed since the last call */
+        inline bool takeFailure()
+        {
+            bool failed = mFailed;
+
+            mFailed = false;
+
+            return failed;
+        }
+
+
+    };
+
+
+    static const uint32_t FastModeClock;
+
+
+    static void begin(uint32_t clock = FastModeClock);
+    static bool recover();
+    static unsigned char requestStatus(uint8_t requested, uint8_t received);
+
+
+    inline static uint32_t clock()
+    {
+        return sClock;
+    }
+
+
+    inline static unsigned long recoveries()
+    {
+        return sRecoveries;
+    }
+
+};
@@ -0,0 +1,102 @@
+#include "Arduino.h"
+
+#include "IntervalHistogram.hpp"
+
+
+/* Bit length of 0 to 15 */
+static const unsigned char sNibbleLength[16] = {
+    0, 1, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4
+};
+
+
+unsigned char IntervalHistogram::bucket(unsigned long interval)
+{
+    if (interval >> 16 != 0) {
+        return BucketsCount - 1;
+    }
+
+    uint16_t value = interval;
+    unsigned char length = 0;
+
+    if (value >> 8 != 0) {
+        value >>= 8;
+        length = 8;
+    }
+
+    if (value >> 4 != 0) {
+        value >>= 4;
+        length += 4;
+    }
+
+    length += sNibbleLength[value];
+
+    return length < BucketsCount ? length : BucketsCount - 1;
+}
+
+
+IntervalHistogram::IntervalHistogram()
+    : mMean16(0),
+    mMarked(false)
+{
+    reset();
+}
+
+
+void IntervalHistogram::record(unsigned long interval)
+{
+    uint16_t &count = mBuckets[bucket(interval)];
+
+    /* Halve rather than saturate, which keeps the proportions */
+
+    if (count == 0xFFFF) {
+        for (unsigned char i = 0; i < BucketsCount; i++) {
+            mBuckets[i] = (mBuckets[i] + 1) >> 1;
+        }
+    }
+
+    count++;
+
+    mCount++;
+    mMean16 += interval - (mMean16 >> 4);
+
+    if (interval > mWorst) {
+        mWorst = interval;
+    }
+}
+
+
+unsigned long IntervalHistogram::percentile(unsigned char percent) const
+{
+    unsigned long total = 0;
+    unsigned long seen = 0;
+
+    for (unsigned char i = 0; i < BucketsCount; i++) {
+        total += mBuckets[i];
+    }
+
+    /* Below 18 * 65535, so the product stays in 32 bits */
+    unsigned long target = (total * percent + 99) / 100;
+
+    for (unsigned char i = 0; i < BucketsCount - 1; i++) {
+        seen += mBuckets[i];
+
+        if (seen >= target) {
+            unsigned long bound = (1UL << i) - 1;
+
+            return bound < mWorst ? bound : mWorst;
+        }
+    }
+
+    return mWorst;
+}
+
+
+void IntervalHistogram::reset()
+{
+    for (unsigned char i = 0; i < BucketsCount; i++) {
+        mBuckets[i] = 0;
+    }
+
+    mCount = 0;
+    mWorst = 0;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+
+#include "Arduino.h"
+
+#include "Time.hpp"
+
+
+/*
+ * Intervals between mark()s in power of two buckets of microseconds:
+ * bucket b holds the intervals whose bit length is b, the last one
+ * everything longer. Recording costs a subtraction, a nibble table
+ * lookup and an increment, so it can run on every pass of the loop.
+ * Percentiles come back as the upper bound of their bucket, which is as
+ * precise as late steering needs; worst() is exact. A full bucket halves
+ * them all, so percentiles weigh recent intervals more after about 64k
+ * of them in one bucket. The rate is the inverse of a moving average
+ * over about the last 16 intervals.
+ */
+class IntervalHistogram
+{
+
+public:
+
+    static const unsigned char BucketsCount = 18;
+
+
+private:
+
+    uint16_t mBuckets[BucketsCount];
+    unsigned long mCount;
+    unsigned long mWorst;
+    unsigned long mMean16;
+    Timestamp<MicrosClock> mLast;
+    bool mMarked;
+
+
+    static unsigned char bucket(unsigned long interval);
+
+
+public:
+
+    explicit IntervalHistogram();
+
+    void record(unsigned long interval);
+
+    /* Upper bound of the bucket below which percent of the intervals lie */
+    unsigned long percentile(unsigned char percent) const;
+
+    /* Forget the intervals but keep the last mark() and the average */
+    void reset();
+
+
+    inline void mark()
+    {
+        Timestamp<MicrosClock> now = Timestamp<MicrosClock>::now();
+
+        if (mMarked) {
+            record((now - mLast).count());
+        }
+
+        mLast = now;
+        mMarked = true;
+    }
+
+
+    inline unsigned long count() const
+    {
+        return mCount;
+    }
+
+
+    inline unsigned long worst() const
+    {
+        return mWorst;
+    }
+
+
+    inline unsigned long mean() const
+    {
+        return mMean16 >> 4;
+    }
+
+
+    /* Marks per second at the average interval */
+    inline unsigned long rate() const
+    {
+        return mean() == 0 ? 0 : 1000000UL / mean();
+    }
+
+
+    inline uint16_t buckets(unsigned char index) const
+    {
+        return mBuckets[index];
+    }
+
+
+};
@@ -0,0 +1,112 @@
+#include <float.h>
+#include <math.h>
+
+#include "Arduino.h"
+
+#include "Application.hpp"
+
+#include "Link.hpp"
+
+
+void Link::receive()
+{
+    const uint8_t *payload = mDecoder.payload();
+    uint8_t age = mSeq - payload[0];
+
+    if (age == 0 || age > Window) {
+
+        /* Planned from ranges we no longer trust; keep the old direction */
+
+        mStale++;
+
+        return;
+    }
+
+    mLatency = micros() - mSentAt[payload[0] % Window];
+
+    if (mLatency > mWorstLatency) {
+        mWorstLatency = mLatency;
+    }
+
+    mDirection.set(
+            (int16_t) LinkProtocol::get16(payload + 1) /
+                (float) LinkProtocol::DirectionScale,
+            (int16_t) LinkProtocol::get16(payload + 3) /
+                (float) LinkProtocol::DirectionScale);
+    mLerpTime = LinkProtocol::get16(payload + 5);
+
+    /* Rounding on the planner may overshoot the unit circle */
+
+    float magnitude = mDirection.sqrMagnitude();
+
+    if (magnitude > 1) {
+        mDirection *= (1 - FLT_EPSILON) / sqrtf(magnitude);
+    }
+
+    directionReceived()->emit();
+}
+
+
+void Link::onLoop()
+{
+    while (mSerial->available() > 0) {
+        if (mDecoder.feed(mSerial->read()) &&
+                mDecoder.type() == LinkProtocol::DirectionFrame &&
+                mDecoder.length() == LinkProtocol::DirectionLength) {
+            receive();
+        }
+    }
+}
+
+
+void Link::onSensorsReady()
+{
+    uint8_t payload[LinkProtocol::MaxPayload];
+    uint8_t frame[LinkProtocol::MaxFrame];
+    const RangeSample *samples = mSensors->samples();
+    uint8_t count = mSensors->samplesCount();
+    unsigned long time = micros();
+
+    if (count > LinkProtocol::MaxRanges) {
+        count = LinkProtocol::MaxRanges;
+    }
+
+    LinkProtocol::put32(payload, time);
+    payload[4] = count;
+
+    for (uint8_t i = 0; i < count; i++) {
+        LinkProtocol::put16(payload + 5 + i * 3, samples[i].range);
+        payload[7 + i * 3] = samples[i].status;
+    }
+
+    uint8_t size = LinkProtocol::encode(LinkProtocol::RangesFrame, mSeq,
+            payload, 5 + count * 3, frame);
+
+    if (mSerial->availableForWrite() < size) {
+        mDropped++;
+
+        return;
+    }
+
+    mSerial->write(frame, size);
+    mSentAt[mSeq % Window] = time;
+    mSeq++;
+    mSent++;
+}
+
+
+Link::Link(HardwareSerial *serial, BreadthSensors *sensors)
+    : EventObject(),
+    mSerial(serial),
+    mSensors(sensors),
+    mSeq(0),
+    mLerpTime(0),
+    mLatency(0),
+    mWorstLatency(0),
+    mSent(0),
+    mDropped(0),
+    mStale(0)
+{
+    EventObjectConnect(Application::instance(), loop, this, onLoop);
+    EventObjectConnect(sensors, ready, this, onSensorsReady);
+}
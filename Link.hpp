@@ -0,0 +1,115 @@
+#pragma once
+
+
+#include "Arduino.h"
+
+#include "BreadthSensors.hpp"
+#include "EventObject.hpp"
+#include "LinkProtocol.hpp"
+#include "Vector2f.hpp"
+
+
+/*
+ * Sensor node end of the board to board link. Every BreadthSensors::ready
+ * is streamed as a RangesFrame without waiting for the planner, which
+ * answers with DirectionFrames that acknowledge the RangesFrame they were
+ * planned from. Up to Window frames may be in flight; the send time of
+ * each is kept by seq so that the acknowledgement yields the end to end
+ * latency. A frame that does not fit into the UART transmit buffer is
+ * dropped rather than blocking the loop.
+ */
+class Link : public EventObject
+{
+
+    EVENT_OBJECT_SIGNAL(Link, directionReceived);
+
+    EVENT_OBJECT_SLOT(Link, onLoop);
+    EVENT_OBJECT_SLOT(Link, onSensorsReady);
+
+
+public:
+
+    static const unsigned char Window = 8;
+
+
+private:
+
+    HardwareSerial *mSerial;
+    BreadthSensors *mSensors;
+    LinkProtocol::Decoder mDecoder;
+
+    unsigned long mSentAt[Window];
+    uint8_t mSeq;
+
+    Vector2f mDirection;
+    unsigned long mLerpTime;
+
+    unsigned long mLatency;
+    unsigned long mWorstLatency;
+    unsigned long mSent;
+    unsigned long mDropped;
+    unsigned long mStale;
+
+
+    void receive();
+
+
+public:
+
+    explicit Link(HardwareSerial *serial, BreadthSensors *sensors);
+
+
+    /* Direction of the last DirectionFrame, scaled to [-1, 1] */
+    inline const Vector2f &direction() const
+    {
+        return mDirection;
+    }
+
+
+    /* Requested lerpDirectionTo() time of the last DirectionFrame, ms */
+    inline unsigned long lerpTime() const
+    {
+        return mLerpTime;
+    }
+
+
+    /* Microseconds from sending a RangesFrame to its acknowledgement */
+    inline unsigned long latency() const
+    {
+        return mLatency;
+    }
+
+
+    inline unsigned long worstLatency() const
+    {
+        return mWorstLatency;
+    }
+
+
+    inline unsigned long sent() const
+    {
+        return mSent;
+    }
+
+
+    /* RangesFrames dropped because the transmit buffer was full */
+    inline unsigned long dropped() const
+    {
+        return mDropped;
+    }
+
+
+    /* DirectionFrames acknowledging a frame older than Window */
+    inline unsigned long stale() const
+    {
+        return mStale;
+    }
+
+
+    inline const LinkProtocol::Decoder &decoder() const
+    {
+        return mDecoder;
+    }
+
+
+};
@@ -0,0 +1,129 @@
+#include <string.h>
+
+#ifdef __AVR__
+#    include <util/crc16.h>
+#endif
+
+#include "LinkProtocol.hpp"
+
+
+LinkProtocol::Decoder::Decoder()
+    : mType(0),
+    mSeq(0),
+    mLength(0),
+    mReceived(0),
+    mState(WaitStart),
+    mCrc(0),
+    mFrameCrc(0),
+    mFrames(0),
+    mErrors(0)
+{
+
+}
+
+
+bool LinkProtocol::Decoder::feed(uint8_t value)
+{
+    switch (mState) {
+    case WaitStart:
+        if (value == StartOfFrame) {
+            mCrc = 0xFFFF;
+            mState = WaitType;
+        }
+
+        return false;
+
+    case WaitType:
+        mType = value;
+        mState = WaitSeq;
+        break;
+
+    case WaitSeq:
+        mSeq = value;
+        mState = WaitLength;
+        break;
+
+    case WaitLength:
+        if (value > MaxPayload) {
+            mErrors++;
+            mState = WaitStart;
+
+            return false;
+        }
+
+        mLength = value;
+        mReceived = 0;
+        mState = value == 0 ? WaitCrcLow : WaitPayload;
+        break;
+
+    case WaitPayload:
+        mPayload[mReceived++] = value;
+
+        if (mReceived == mLength) {
+            mState = WaitCrcLow;
+        }
+
+        break;
+
+    case WaitCrcLow:
+        mFrameCrc = value;
+        mState = WaitCrcHigh;
+
+        return false;
+
+    case WaitCrcHigh:
+        mFrameCrc |= (uint16_t) value << 8;
+        mState = WaitStart;
+
+        if (mFrameCrc != mCrc) {
+            mErrors++;
+
+            return false;
+        }
+
+        mFrames++;
+
+        return true;
+    }
+
+    mCrc = crc16(mCrc, value);
+
+    return false;
+}
+
+
+uint16_t LinkProtocol::crc16(uint16_t crc, uint8_t value)
+{
+#ifdef __AVR__
+    return _crc_xmodem_update(crc, value);
+#else
+    crc ^= (uint16_t) value << 8;
+
+    for (unsigned char i = 0; i < 8; i++) {
+        crc = crc & 0x8000 ? crc << 1 ^ 0x1021 : crc << 1;
+    }
+
+    return crc;
+#endif
+}
+
+
+uint8_t LinkProtocol::encode(uint8_t type, uint8_t seq, const uint8_t *payload,
+        uint8_t length, uint8_t *out)
+{
+    uint16_t crc = 0xFFFF;
+
+    out[0] = StartOfFrame;
+    out[1] = type;
+    out[2] = seq;
+    out[3] = length;
+    memcpy(out + 4, payload, length);
+
+    for (uint8_t i = 1; i < length + 4; i++) {
+        crc = crc16(crc, out[i]);
+    }
+
+    put16(out + length + 4, crc);
+
+    return length + Overhead;
+}
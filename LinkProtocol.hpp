@@ -0,0 +1,158 @@
+#pragma once
+
+
+#include <stdint.h>
+
+
+/*
+ * Framing for the board to board link. A frame is
+ *
+ *     StartOfFrame, type, seq, length, payload[length], crc (LE)
+ *
+ * where crc is CRC-16/CCITT-FALSE over type, seq, length and the payload.
+ * There is no byte stuffing: a receiver that loses sync drops bytes until
+ * the next StartOfFrame and relies on the CRC to reject false starts.
+ * Multi-byte payload fields are little endian. The header has no Arduino
+ * dependencies so that the host tools share it.
+ */
+class LinkProtocol
+{
+
+public:
+
+    enum Type
+    {
+
+        /*
+         * Sensor node to planner: uint32 time (micros), uint8 count, then
+         * count times uint16 range (mm) and uint8 RangeSensor::RangeStatus
+         */
+        RangesFrame = 1,
+
+        /*
+         * Planner to sensor node: uint8 acknowledged RangesFrame seq, int16
+         * x and y in DirectionScale units, uint16 lerp time (ms)
+         */
+        DirectionFrame = 2
+
+    };
+
+
+    static const uint8_t StartOfFrame = 0xA5;
+    static const uint8_t MaxPayload = 32;
+    static const uint8_t Overhead = 6;
+    static const uint8_t MaxFrame = MaxPayload + Overhead;
+    static const uint8_t MaxRanges = 8;
+    static const uint8_t DirectionLength = 7;
+    static const int16_t DirectionScale = 16384;
+
+
+    class Decoder
+    {
+
+        enum State
+        {
+            WaitStart,
+            WaitType,
+            WaitSeq,
+            WaitLength,
+            WaitPayload,
+            WaitCrcLow,
+            WaitCrcHigh
+        };
+
+
+        uint8_t mPayload[MaxPayload];
+        uint8_t mType;
+        uint8_t mSeq;
+        uint8_t mLength;
+        uint8_t mReceived;
+        uint8_t mState;
+        uint16_t mCrc;
+        uint16_t mFrameCrc;
+
+        unsigned long mFrames;
+        unsigned long mErrors;
+
+
+    public:
+
+        explicit Decoder();
+
+        /* Consume one byte, return whether it completed a valid frame */
+        bool feed(uint8_t value);
+
+
+        inline uint8_t type() const
+        {
+            return mType;
+        }
+
+
+        inline uint8_t seq() const
+        {
+            return mSeq;
+        }
+
+
+        inline uint8_t length() const
+        {
+            return mLength;
+        }
+
+
+        inline const uint8_t *payload() const
+        {
+            return mPayload;
+        }
+
+
+        inline unsigned long frames() const
+        {
+            return mFrames;
+        }
+
+
+        /* Frames dropped for a bad length or CRC */
+        inline unsigned long errors() const
+        {
+            return mErrors;
+        }
+
+
+    };
+
+
+    static uint16_t crc16(uint16_t crc, uint8_t value);
+
+    /* Write a frame to out (MaxFrame bytes) and return its size */
+    static uint8_t encode(uint8_t type, uint8_t seq, const uint8_t *payload,
+            uint8_t length, uint8_t *out);
+
+
+    inline static void put16(uint8_t *out, uint16_t value)
+    {
+        out[0] = value;
+        out[1] = value >> 8;
+    }
+
+
+    inline static void put32(uint8_t *out, uint32_t value)
+    {
+        put16(out, value);
+        put16(out + 2, value >> 16);
+    }
+
+
+    inline static uint16_t get16(const uint8_t *in)
+    {
+        return (uint16_t) in[0] | (uint16_t) in[1] << 8;
+    }
+
+
+    inline static uint32_t get32(const uint8_t *in)
+    {
+        return (uint32_t) get16(in) | (uint32_t) get16(in + 2) << 16;
+    }
+
+};
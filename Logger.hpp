@@ -2,6 +2,13 @@
 #pragma once
 
 
+#include <stddef.h>
+
+
+/* size_t is unsigned long on LP64 hosts and must not be overloaded twice */
+#define LOGGER_HAS_SIZE_T (__SIZEOF_SIZE_T__ != __SIZEOF_LONG__)
+
+
 class Logger
 {
 
@@ -13,7 +20,9 @@ public:
     virtual Logger & operator<<(double value) = 0;
     virtual Logger & operator<<(bool value) = 0;
     virtual Logger & operator<<(unsigned long value) = 0;
+#if LOGGER_HAS_SIZE_T
     virtual Logger & operator<<(size_t value) = 0;
+#endif
     virtual Logger & operator<<(const char *value) = 0;
 
 };
@@ -0,0 +1,264 @@
+#include "Arduino.h"
+
+#include <stdlib.h>
+
+#ifndef __AVR__
+#    include <malloc.h>
+#    include <new>
+#endif
+
+#include "Debug.hpp"
+
+#include "Memory.hpp"
+
+
+#define MEMORY_PAINT 0xC5
+
+
+unsigned char Memory::sSubsystem = Memory::Other;
+unsigned long Memory::sAllocations[SubsystemsCount];
+unsigned long Memory::sBytes[SubsystemsCount];
+unsigned long Memory::sFrees = 0;
+size_t Memory::sLive = 0;
+size_t Memory::sLivePeak = 0;
+size_t Memory::sHeapPeak = 0;
+
+
+#ifdef __AVR__
+
+
+struct __freelist
+{
+    size_t sz;
+    struct __freelist *nx;
+};
+
+
+extern char __heap_start;
+extern char *__brkval;
+extern struct __freelist *__flp;
+
+
+static void paintStack() __attribute__((naked, used, section(".init3")));
+
+
+/*
+ * Runs from the startup code once SP and r1 are set up, before any
+ * constructor, so every byte between the heap start and the stack
+ * is still unused.
+ */
+static void paintStack()
+{
+    for (uint8_t *p = (uint8_t *) &__heap_start; p <= (uint8_t *) SP; p++) {
+        *p = MEMORY_PAINT;
+    }
+}
+
+
+static inline char *heapTop()
+{
+    return __brkval != 0 ? __brkval : &__heap_start;
+}
+
+
+static inline size_t blockSize(void *pointer)
+{
+
+    /* avr-libc keeps the chunk size right in front of the block */
+
+    return ((size_t *) pointer)[-1];
+}
+
+
+#else
+
+
+uintptr_t Memory::sStackBase = 0;
+uintptr_t Memory::sStackLow = UINTPTR_MAX;
+
+
+static inline size_t blockSize(void *pointer)
+{
+    return malloc_usable_size(pointer);
+}
+
+
+#endif
+
+
+/*
+ * These replace the Arduino core's new.cpp. new never returns nullptr:
+ * running out of heap panics on the board, which has no exceptions, and
+ * throws std::bad_alloc on the host like the standard operator new.
+ */
+static void *allocate(size_t size)
+{
+    /* malloc(0) may return nullptr, new has to return a unique pointer */
+    void *pointer = malloc(size != 0 ? size : 1);
+
+#ifdef __AVR__
+    debugAssert(pointer != nullptr);
+#else
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+#endif
+
+    Memory::allocated(pointer);
+
+    return pointer;
+}
+
+
+void *operator new(size_t size)
+{
+    return allocate(size);
+}
+
+
+void *operator new[](size_t size)
+{
+    return allocate(size);
+}
+
+
+void operator delete(void *pointer)
+{
+    Memory::freed(pointer);
+    free(pointer);
+}
+
+
+void operator delete[](void *pointer)
+{
+    Memory::freed(pointer);
+    free(pointer);
+}
+
+
+#if __cplusplus >= 201402L
+
+
+void operator delete(void *pointer, size_t size)
+{
+    Memory::freed(pointer);
+    free(pointer);
+}
+
+
+void operator delete[](void *pointer, size_t size)
+{
+    Memory::freed(pointer);
+    free(pointer);
+}
+
+
+#endif
+
+
+void Memory::begin()
+{
+#ifndef __AVR__
+    sStackBase = (uintptr_t) __builtin_frame_address(0);
+    sStackLow = sStackBase;
+#endif
+}
+
+
+void Memory::allocated(void *pointer)
+{
+    if (pointer == nullptr) {
+        return;
+    }
+
+    size_t size = blockSize(pointer);
+
+    sAllocations[sSubsystem]++;
+    sBytes[sSubsystem] += size;
+    sLive += size;
+
+    if (sLive > sLivePeak) {
+        sLivePeak = sLive;
+    }
+
+#ifdef __AVR__
+    size_t extent = heapTop() - &__heap_start;
+
+    if (extent > sHeapPeak) {
+        sHeapPeak = extent;
+    }
+#else
+    sHeapPeak = sLivePeak;
+#endif
+}
+
+
+void Memory::freed(void *pointer)
+{
+    if (pointer == nullptr) {
+        return;
+    }
+
+    sFrees++;
+    sLive -= blockSize(pointer);
+}
+
+
+size_t Memory::stackPeak()
+{
+#ifdef __AVR__
+    const uint8_t *p = (const uint8_t *) heapTop();
+
+    while (p <= (const uint8_t *) RAMEND && *p == MEMORY_PAINT) {
+        p++;
+    }
+
+    return RAMEND + 1 - (uintptr_t) p;
+#else
+    return sStackBase - sStackLow;
+#endif
+}
+
+
+/* Bytes between the top of the heap and the stack pointer */
+size_t Memory::freeMemory()
+{
+#ifdef __AVR__
+    return SP - (uintptr_t) heapTop();
+#else
+    return 0;
+#endif
+}
+
+
+/*
+ * Freed blocks below the heap top. Many small blocks with a small largest
+ * one mean new can fail although freeMemory() plus free look sufficient.
+ */
+void Memory::fragmentation(Fragmentation *result)
+{
+    result->free = 0;
+    result->largest = 0;
+    result->blocks = 0;
+
+#ifdef __AVR__
+    for (struct __freelist *block = __flp; block != 0; block = block->nx) {
+        result->free += block->sz;
+        result->blocks++;
+
+        if (block->sz > result->largest) {
+            result->largest = block->sz;
+        }
+    }
+#elif defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+
+    /* glibc only has arena totals; largest is an upper bound */
+
+    struct mallinfo2 info = mallinfo2();
+
+    result->free = info.fordblks;
+    result->largest = info.fordblks;
+    result->blocks = info.ordblks > 255 ? 255 : info.ordblks;
+#endif
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/*
+ * RAM accounting for an 8 KB board. On AVR the stack is painted before
+ * the constructors run and stackPeak() finds the deepest byte it ever
+ * reached; heap figures come from avr-libc's __brkval and free list.
+ * Global operator new and delete count allocations against the subsystem
+ * of the innermost Memory::Scope. The host build keeps the counts, takes
+ * the heap figures from live allocation sizes and estimates the stack by
+ * sampling it on every emit.
+ */
+class Memory
+{
+
+public:
+
+    enum Subsystem
+    {
+        Other,
+        Events,
+        Sensors,
+        Motion,
+        Diagnostics,
+        SubsystemsCount
+    };
+
+
+    /* Attribute the allocations made during its lifetime to a subsystem */
+    class Scope
+    {
+
+        unsigned char mPrevious;
+
+
+    public:
+
+        inline explicit Scope(unsigned char subsystem)
+            : mPrevious(sSubsystem)
+        {
+            sSubsystem = subsystem;
+        }
+
+
+        inline ~Scope()
+        {
+            sSubsystem = mPrevious;
+        }
+
+
+    };
+
+
+    struct Fragmentation
+    {
+        size_t free;
+        size_t largest;
+        unsigned char blocks;
+    };
+
+
+private:
+
+    static unsigned char sSubsystem;
+    static unsigned long sAllocations[SubsystemsCount];
+    static unsigned long sBytes[SubsystemsCount];
+    static unsigned long sFrees;
+    static size_t sLive;
+    static size_t sLivePeak;
+    static size_t sHeapPeak;
+
+#ifndef __AVR__
+    static uintptr_t sStackBase;
+    static uintptr_t sStackLow;
+#endif
+
+
+public:
+
+    static void begin();
+
+    static void allocated(void *pointer);
+    static void freed(void *pointer);
+
+    static size_t stackPeak();
+    static size_t freeMemory();
+    static void fragmentation(Fragmentation *result);
+
+
+    inline static unsigned char subsystem()
+    {
+        return sSubsystem;
+    }
+
+
+    inline static void sampleStack()
+    {
+#ifndef __AVR__
+        char marker;
+
+        if ((uintptr_t) &marker < sStackLow) {
+            sStackLow = (uintptr_t) &marker;
+        }
+#endif
+    }
+
+
+    inline static unsigned long allocations(unsigned char subsystem)
+    {
+        return sAllocations[subsystem];
+    }
+
+
+    inline static unsigned long bytes(unsigned char subsystem)
+    {
+        return sBytes[subsystem];
+    }
+
+
+    inline static unsigned long frees()
+    {
+        return sFrees;
+    }
+
+
+    /* Bytes handed out by operator new and not yet deleted */
+    inline static size_t live()
+    {
+        return sLive;
+    }
+
+
+    inline static size_t livePeak()
+    {
+        return sLivePeak;
+    }
+
+
+    /* Highest extent of the heap above its start, in bytes */
+    inline static size_t heapPeak()
+    {
+        return sHeapPeak;
+    }
+
+
+};
@@ -0,0 +1,229 @@
+#include <math.h>
+
+#include "MotionProfile.hpp"
+
+
+/*
+ * Whether the axis has to decelerate: the stopping distance at the current
+ * speed is v (v + lead) / 2a, where lead covers half a step of
+ * discretisation and the time the jerk limit needs to ramp the
+ * deceleration in from the current acceleration. Past mBrakeDistance no
+ * speed the limits allow has to brake yet; within it, dropping
+ * mBrakeShift bits from both speed terms keeps both sides in 32 bits.
+ */
+bool MotionProfile::braking(int32_t speed, int32_t distance,
+        int32_t lead) const
+{
+    if (distance > mBrakeDistance) {
+        return false;
+    }
+
+    /* Only for limits of many units per step, far beyond any axis here */
+
+    if (mBrakeShift > 15) {
+        return (int64_t) (2 * mMaxAcceleration) * distance <=
+            (int64_t) speed * (speed + lead);
+    }
+
+    return 2 * mMaxAcceleration * (distance >> (2 * mBrakeShift)) <=
+        (speed >> mBrakeShift) * ((speed + lead) >> mBrakeShift);
+}
+
+
+/*
+ * Bound braking()'s operands for the limits and the current speed, which
+ * the velocity clamp in step() never lets grow past the larger of the
+ * two: speed + lead stays below bound, and the distance that matters
+ * below the stopping distance bound^2 / 2a.
+ */
+void MotionProfile::updateBraking()
+{
+    int32_t speed = mVelocity < 0 ? -mVelocity : mVelocity;
+    float bound = (float) (speed > mMaxVelocity ? speed : mMaxVelocity) +
+        mMaxAcceleration + 2.0f * mMaxAcceleration * mRampSteps;
+    float distance = bound * bound / (2.0f * mMaxAcceleration);
+
+    mBrakeShift = 0;
+
+    while (ldexpf(bound, -mBrakeShift) >= 46340) {
+        mBrakeShift++;
+    }
+
+    /* The largest float below 2^31 */
+    mBrakeDistance = distance < 2147483520.0f ? (int32_t) distance :
+        (int32_t) 2147483520L;
+}
+
+
+MotionProfile::MotionProfile()
+    : mPosition(0),
+    mVelocity(0),
+    mAcceleration(0),
+    mTarget(0),
+    mMaxVelocity(0),
+    mMaxAcceleration(0),
+    mMaxJerk(0),
+    mRampSteps(0),
+    mBrakeDistance(0),
+    mBrakeShift(0),
+    mBraking(false)
+{
+
+}
+
+
+void MotionProfile::setLimits(float velocity, float acceleration, float jerk,
+        unsigned long period)
+{
+    float dt = period / 1000.0f;
+
+    setMaxVelocity(velocity, period);
+
+    mMaxAcceleration = toFixed(acceleration * dt * dt);
+    mMaxJerk = toFixed(jerk * dt * dt * dt);
+
+    if (mMaxAcceleration < 1) {
+        mMaxAcceleration = 1;
+    }
+
+    if (mMaxJerk < 1) {
+        mMaxJerk = 1;
+    }
+
+    mRampSteps = (mMaxAcceleration + mMaxJerk - 1) / mMaxJerk;
+
+    updateBraking();
+}
+
+
+void MotionProfile::setMaxVelocity(float velocity, unsigned long period)
+{
+    mMaxVelocity = toFixed(velocity * period / 1000.0f);
+
+    if (mMaxVelocity < 1) {
+        mMaxVelocity = 1;
+    }
+
+    if (mMaxAcceleration != 0) {
+        updateBraking();
+    }
+}
+
+
+void MotionProfile::reset(float value)
+{
+    mPosition = toFixed(value);
+    mTarget = mPosition;
+    mVelocity = 0;
+    mAcceleration = 0;
+    mBraking = false;
+}
+
+
+void MotionProfile::settle()
+{
+    mPosition = mTarget;
+    mVelocity = 0;
+    mAcceleration = 0;
+    mBraking = false;
+}
+
+
+/* Advance one period; return whether the axis is still moving */
+bool MotionProfile::step()
+{
+    int32_t error = mTarget - mPosition;
+
+    if (error == 0 && mVelocity == 0) {
+        mAcceleration = 0;
+
+        return false;
+    }
+
+    bool forward = error > 0;
+    int32_t distance = forward ? error : -error;
+    int32_t speed = forward ? mVelocity : -mVelocity;
+
+    /*
+     * Within one step of acceleration and all but stopped: land, rather
+     * than hover below the resolution the braking estimate works at
+     */
+
+    if (distance <= mMaxAcceleration && speed <= mMaxAcceleration &&
+            speed >= -mMaxAcceleration) {
+        settle();
+
+        return false;
+    }
+    int32_t current = forward ? mAcceleration : -mAcceleration;
+    int32_t lead = mMaxAcceleration +
+        (mMaxAcceleration + current) * mRampSteps;
+    int32_t ramped = speed + ((current * mRampSteps) >> 1);
+    bool brake = speed > 0 && braking(speed, distance, lead);
+    int32_t acceleration;
+
+    /*
+     * Once braking has started the axis only coasts or decelerates until
+     * it stops; re-accelerating on a marginal estimate makes it wobble.
+     * Towards the velocity limit the acceleration is ramped out early
+     * enough for the jerk limit to land on it, from below or, after
+     * setMaxVelocity() lowered it, from above.
+     */
+
+    if (speed <= 0) {
+        mBraking = false;
+    } else if (brake) {
+        mBraking = true;
+    }
+
+    if (mBraking) {
+        if (speed <= ((-current * mRampSteps) >> 1)) {
+            acceleration = 0;
+        } else if (brake) {
+            acceleration = -mMaxAcceleration;
+        } else {
+            acceleration = 0;
+        }
+    } else if (speed > mMaxVelocity) {
+        acceleration = ramped > mMaxVelocity ? -mMaxAcceleration : 0;
+    } else if (ramped < mMaxVelocity) {
+        acceleration = mMaxAcceleration;
+    } else {
+        acceleration = 0;
+    }
+
+    if (!forward) {
+        acceleration = -acceleration;
+    }
+
+    int32_t jerk = acceleration - mAcceleration;
+    int32_t limit = mVelocity > mMaxVelocity ? mVelocity :
+        mVelocity < -mMaxVelocity ? -mVelocity : mMaxVelocity;
+
+    if (jerk > mMaxJerk) {
+        jerk = mMaxJerk;
+    } else if (jerk < -mMaxJerk) {
+        jerk = -mMaxJerk;
+    }
+
+    mAcceleration += jerk;
+    mVelocity += mAcceleration;
+
+    if (mVelocity > limit) {
+        mVelocity = limit;
+    } else if (mVelocity < -limit) {
+        mVelocity = -limit;
+    }
+
+    mPosition += mVelocity;
+
+    int32_t remaining = mTarget - mPosition;
+
+    if (remaining == 0 || (remaining ^ error) < 0) {
+        settle();
+
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+
+#include <stdint.h>
+
+
+/*
+ * Jerk limited (S-curve) profile for one axis, advanced by step() at a
+ * fixed period. All state is fixed point with FractionBits fractional
+ * bits and per-tick units, so step() is additions, comparisons and two
+ * 32 bit multiplies; the divisions happen in setLimits().
+ * Lowering the velocity limit below the current velocity decelerates to
+ * it within the acceleration and jerk limits.
+ */
+class MotionProfile
+{
+
+    int32_t mPosition;
+    int32_t mVelocity;
+    int32_t mAcceleration;
+    int32_t mTarget;
+
+    int32_t mMaxVelocity;
+    int32_t mMaxAcceleration;
+    int32_t mMaxJerk;
+    int32_t mRampSteps;
+
+    /* See updateBraking() */
+    int32_t mBrakeDistance;
+    unsigned char mBrakeShift;
+
+    bool mBraking;
+
+
+    bool braking(int32_t speed, int32_t distance, int32_t lead) const;
+    void updateBraking();
+    void settle();
+
+
+public:
+
+    static const unsigned char FractionBits = 24;
+    static const int32_t One = (int32_t) 1 << FractionBits;
+
+
+    explicit MotionProfile();
+
+    /*
+     * Limits are given per second (velocity), per second squared and per
+     * second cubed; period is the step() period in milliseconds.
+     */
+    void setLimits(float velocity, float acceleration, float jerk,
+            unsigned long period);
+    void setMaxVelocity(float velocity, unsigned long period);
+    void reset(float value);
+    bool step();
+
+
+    inline void setTarget(float value)
+    {
+        mTarget = toFixed(value);
+        mBraking = false;
+    }
+
+
+    inline float target() const
+    {
+        return mTarget * (1.0f / One);
+    }
+
+
+    inline float position() const
+    {
+        return mPosition * (1.0f / One);
+    }
+
+
+    inline bool settled() const
+    {
+        return mPosition == mTarget && mVelocity == 0;
+    }
+
+
+    inline static int32_t toFixed(float value)
+    {
+        return value * One;
+    }
+
+};
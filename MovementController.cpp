@@ -1,3 +1,4 @@
+#include <math.h>
 
 #include "Arduino.h"
 
@@ -7,47 +8,79 @@
 #include "MovementController.hpp"
 
 
-void MovementController::onLoop()
+const unsigned long MovementController::ProfilePeriod = 10;
+const unsigned long MovementController::Margin = 3 * ProfilePeriod;
+
+
+bool MovementController::inhibits(float x) const
 {
-    updateDirection();
+    return (x > 0 && (mInhibited & InhibitForward)) ||
+        (x < 0 && (mInhibited & InhibitBackward));
 }
 
 
-unsigned long MovementController::targetTime() const
+/*
+ * Rate at which a move of distance, speeding up and slowing down at the
+ * acceleration limit with jerk ramps, takes seconds:
+ *
+ *     seconds = distance / rate + rate / acceleration + acceleration / jerk
+ *
+ * solved for the lower rate, with Margin for the steps the profile loses
+ * to its resolution. A move that cannot make it takes mMaxRate.
+ */
+float MovementController::deadlineRate(float distance, float seconds) const
 {
-    unsigned long time = millis();
+    float t = seconds - mMaxAcceleration / mMaxJerk - Margin / 1000.0f;
+    float a = mMaxAcceleration;
+    float discriminant = a * a * t * t - 4 * a * distance;
+
+    if (t <= 0 || discriminant < 0) {
+        return mMaxRate;
+    }
 
-    return mTargetTime <= time ? time + 1 : mTargetTime;
+    float rate = (a * t - sqrt(discriminant)) / 2;
+
+    return rate < mMaxRate ? rate : mMaxRate;
 }
 
 
-void MovementController::updateDirection()
+void MovementController::onProfileTimerExpired()
 {
-    Vector2f direction = this->direction();
+    bool moving = mProfileX.step();
+
+    moving = mProfileY.step() || moving;
 
-    if (direction == mTargetDirection) {
-        return;
+    if (inhibits(mProfileX.position())) {
+        mProfileX.reset(0);
     }
 
-    unsigned long time = millis();
-    unsigned long lastEmitted = Application::instance()->loop()->lastEmitted();
-    unsigned long timeDelta = lastEmitted > time ? 0 : lastEmitted - time;
-    Vector2f diff = (mTargetDirection - direction) / (targetTime() - time);
-    
-    direction += diff * timeDelta;
+    mDirection.set(mProfileX.position(), mProfileY.position());
+    writeDirection(mDirection);
+    directionChanged()->emit();
 
-    if ((direction - mTargetDirection).dot(diff) < 0) {
-        direction = mTargetDirection;
+    if (!moving) {
+        mProfileTimer.stop();
     }
+}
+
+
+void MovementController::writeDirection(const Vector2f &)
+{
 
-    setDirection(direction);
 }
 
 
 MovementController::MovementController()
-    : EventObject()
+    : EventObject(),
+    mProfileTimer(ProfilePeriod),
+    mInhibited(0)
 {
-    EventObjectConnect(Application::instance(), loop, this, onLoop);
+    EventObjectConnect(&mProfileTimer, expired, this, onProfileTimerExpired);
+
+    /* Every profile step is one period of motion; do not drop any */
+    mProfileTimer.setPolicy(Timer::Burst);
+
+    setProfileLimits(2, 8, 80);
 }
 
 
@@ -61,9 +94,13 @@ void MovementController::setDirection(const Vector2f &value)
 {
     debugAssert(value.sqrMagnitude() <= 1);
 
-    mDirection = value;
-    mTargetDirection = value;
-    mTargetTime = millis();
+    mProfileTimer.stop();
+    mProfileX.reset(inhibits(value.x()) ? 0 : value.x());
+    mProfileY.reset(value.y());
+
+    mDirection.set(mProfileX.position(), value.y());
+    writeDirection(mDirection);
+    directionChanged()->emit();
 }
 
 
@@ -72,8 +109,47 @@ void MovementController::lerpDirectionTo(const Vector2f &value,
 {
     debugAssert(value.sqrMagnitude() <= 1);
 
-    mTargetDirection = value;
-    mTargetTime = millis() + time;
+    float rateX = mMaxRate;
+    float rateY = mMaxRate;
+
+    if (time != 0) {
+        float seconds = time / 1000.0f;
 
-    updateDirection();
+        rateX = deadlineRate(fabs(value.x() - mDirection.x()), seconds);
+        rateY = deadlineRate(fabs(value.y() - mDirection.y()), seconds);
+    }
+
+    mProfileX.setMaxVelocity(rateX, ProfilePeriod);
+    mProfileY.setMaxVelocity(rateY, ProfilePeriod);
+    mProfileX.setTarget(value.x());
+    mProfileY.setTarget(value.y());
+
+    if (!mProfileTimer.running()) {
+        mProfileTimer.start();
+    }
+}
+
+
+void MovementController::setProfileLimits(float rate, float acceleration,
+        float jerk)
+{
+    mMaxRate = rate;
+    mMaxAcceleration = acceleration;
+    mMaxJerk = jerk;
+
+    mProfileX.setLimits(rate, acceleration, jerk, ProfilePeriod);
+    mProfileY.setLimits(rate, acceleration, jerk, ProfilePeriod);
+}
+
+
+void MovementController::setInhibited(unsigned char mask)
+{
+    mInhibited = mask;
+
+    if (inhibits(mDirection.x())) {
+        mProfileX.reset(0);
+        mDirection.setX(0);
+        writeDirection(mDirection);
+        directionChanged()->emit();
+    }
 }
@@ -1,34 +1,84 @@
-
 #pragma once
 
 
 #include "EventObject.hpp"
+#include "MotionProfile.hpp"
+#include "Timer.hpp"
 #include "Vector2f.hpp"
 
 
 class MovementController : public EventObject
 {
 
-    EVENT_OBJECT_SLOT(MovementController, onLoop);
+    EVENT_OBJECT_SIGNAL(MovementController, directionChanged);
+
+    EVENT_OBJECT_SLOT(MovementController, onProfileTimerExpired);
+
 
+    Timer mProfileTimer;
+    MotionProfile mProfileX;
+    MotionProfile mProfileY;
 
     Vector2f mDirection;
-    Vector2f mTargetDirection;
 
-    unsigned long mTargetTime;
+    float mMaxRate;
+    float mMaxAcceleration;
+    float mMaxJerk;
+
+    unsigned char mInhibited;
+
 
+    bool inhibits(float x) const;
+    float deadlineRate(float distance, float seconds) const;
 
-    unsigned long targetTime() const;
 
-    void updateDirection();
+protected:
+
+    /* Apply a direction to the hardware; called for every profile step */
+    virtual void writeDirection(const Vector2f &value);
 
 
 public:
 
+    enum Inhibit
+    {
+        InhibitForward = 1,
+        InhibitBackward = 2
+    };
+
+
+    static const unsigned long ProfilePeriod;
+
+    /* Allowance for a lerpDirectionTo() with a time, ms */
+    static const unsigned long Margin;
+
+
     explicit MovementController();
 
     virtual Vector2f direction() const;
     virtual void setDirection(const Vector2f &value);
+
+    /*
+     * Move towards value along a jerk limited profile. A non-zero time
+     * lowers the velocity limit so that the move arrives about that many
+     * milliseconds from now, or as early as the limits allow.
+     */
     virtual void lerpDirectionTo(const Vector2f &value, unsigned long time = 0);
 
+    /* Limits per second, per second squared and per second cubed */
+    void setProfileLimits(float rate, float acceleration, float jerk);
+
+    /*
+     * Hold x at 0 while it points into an inhibited direction. Inhibiting
+     * the current direction writes the stop before returning.
+     */
+    void setInhibited(unsigned char mask);
+
+
+    inline unsigned char inhibited() const
+    {
+        return mInhibited;
+    }
+
+
 };
@@ -0,0 +1,139 @@
+#include <math.h>
+
+#include "Arduino.h"
+
+#include "Odometry.hpp"
+
+
+/* sin(i * pi / 128) as Q2.14, one quarter wave plus the end point */
+static const int16_t sQuarterSine[65] PROGMEM = {
+    0, 402, 804, 1205, 1606, 2006, 2404, 2801,
+    3196, 3590, 3981, 4370, 4756, 5139, 5520, 5897,
+    6270, 6639, 7005, 7366, 7723, 8076, 8423, 8765,
+    9102, 9434, 9760, 10080, 10394, 10702, 11003, 11297,
+    11585, 11866, 12140, 12406, 12665, 12916, 13160, 13395,
+    13623, 13842, 14053, 14256, 14449, 14635, 14811, 14978,
+    15137, 15286, 15426, 15557, 15679, 15791, 15893, 15986,
+    16069, 16143, 16207, 16261, 16305, 16340, 16364, 16379,
+    16384
+};
+
+
+int16_t Odometry::sine(uint16_t angle)
+{
+    uint16_t offset = angle & 0x3FFF;
+
+    if (angle & 0x4000) {
+        offset = 0x4000 - offset;
+    }
+
+    unsigned char index = offset >> 8;
+    int16_t value = pgm_read_word(&sQuarterSine[index]);
+
+    if (index < 64) {
+        int16_t next = pgm_read_word(&sQuarterSine[index + 1]);
+
+        value += ((int32_t) (next - value) * (offset & 0xFF)) >> 8;
+    }
+
+    return angle & 0x8000 ? -value : value;
+}
+
+
+void Odometry::onDirectionChanged()
+{
+    Vector2f direction = mController->direction();
+    float period = mTimer.timeout() / 1000.0f;
+    float turn = tan(direction.y() * mMaxSteering) / mWheelBase;
+
+    /* mm Q8 per period, and heading units per mm Q8 as Q16 */
+    mStep = direction.x() * mMaxSpeed * period * 256;
+    mCurvature = turn * (65536 / (2 * M_PI)) * 256;
+    mTickStep = direction.x() < 0 ? -mTickLength * 256 : mTickLength * 256;
+}
+
+
+void Odometry::onTimerExpired()
+{
+    int32_t step;
+
+    if (mEncoder == nullptr) {
+        step = mStep * mTimer.coalesced();
+    } else {
+        uint16_t ticks = mEncoder->ticks();
+
+        step = (int32_t) (uint16_t) (ticks - mLastTicks) * mTickStep;
+        mLastTicks = ticks;
+    }
+
+    if (step == 0) {
+        return;
+    }
+
+    /* Midpoint rule: advance along the average heading of the step */
+    int16_t turn = (step * mCurvature) >> 16;
+    uint16_t heading = mPose.heading + (turn >> 1);
+
+    mPose.x += (step * cosine(heading)) >> 14;
+    mPose.y += (step * sine(heading)) >> 14;
+    mPose.heading += turn;
+
+    int32_t dx = mPose.x - mPublished.x;
+    int32_t dy = mPose.y - mPublished.y;
+    int16_t cosHeading = cosine(mPublished.heading);
+    int16_t sinHeading = sine(mPublished.heading);
+
+    mDelta.x = (dx * cosHeading + dy * sinHeading) >> 14;
+    mDelta.y = (dy * cosHeading - dx * sinHeading) >> 14;
+    mDelta.heading = mPose.heading - mPublished.heading;
+    mPublished = mPose;
+
+    moved()->emit();
+}
+
+
+Odometry::Odometry(MovementController *controller, float wheelBase,
+        float maxSpeed, float maxSteering, unsigned long period)
+    : EventObject(),
+    mController(controller),
+    mEncoder(nullptr),
+    mTimer(period),
+    mLastTicks(0),
+    mWheelBase(wheelBase),
+    mMaxSpeed(maxSpeed),
+    mMaxSteering(maxSteering),
+    mTickLength(0),
+    mStep(0),
+    mTickStep(0),
+    mCurvature(0)
+{
+    EventObjectConnect(controller, directionChanged, this,
+            onDirectionChanged);
+    EventObjectConnect(&mTimer, expired, this, onTimerExpired);
+
+    reset();
+    mTimer.start();
+}
+
+
+void Odometry::setEncoder(WheelEncoder *encoder, float tickLength)
+{
+    mEncoder = encoder;
+    mTickLength = tickLength;
+
+    if (encoder != nullptr) {
+        mLastTicks = encoder->ticks();
+    }
+
+    onDirectionChanged();
+}
+
+
+void Odometry::reset()
+{
+    mPose.x = 0;
+    mPose.y = 0;
+    mPose.heading = 0;
+    mPublished = mPose;
+    mDelta = mPose;
+}
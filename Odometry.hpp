@@ -0,0 +1,100 @@
+#pragma once
+
+
+#include <stdint.h>
+
+#include "EventObject.hpp"
+#include "MovementController.hpp"
+#include "Timer.hpp"
+#include "WheelEncoder.hpp"
+
+
+/*
+ * Position in mm as Q24.8 and heading as a binary angle, 65536 units per
+ * turn, so heading arithmetic wraps for free.
+ */
+struct Pose
+{
+    int32_t x;
+    int32_t y;
+    uint16_t heading;
+};
+
+
+/*
+ * Dead reckoning through a bicycle model of the rickshaw: the rear axle
+ * travels along the heading and turns by distance * tan(steering) /
+ * wheelBase. The speed is either the commanded one or, once an encoder is
+ * set, the measured one. Integration runs at a fixed rate in fixed point;
+ * floats are only touched when a new direction is commanded.
+ */
+class Odometry : public EventObject
+{
+
+    EVENT_OBJECT_SIGNAL(Odometry, moved);
+
+    EVENT_OBJECT_SLOT(Odometry, onDirectionChanged);
+    EVENT_OBJECT_SLOT(Odometry, onTimerExpired);
+
+
+    MovementController * const mController;
+    WheelEncoder *mEncoder;
+    Timer mTimer;
+
+    /* Own count: takeTicks() belongs to the SpeedController */
+    uint16_t mLastTicks;
+
+    Pose mPose;
+    Pose mPublished;
+    Pose mDelta;
+
+    const float mWheelBase;
+    const float mMaxSpeed;
+    const float mMaxSteering;
+    float mTickLength;
+
+    int32_t mStep;
+    int32_t mTickStep;
+    int32_t mCurvature;
+
+
+public:
+
+    /* Sine of a binary angle, Q2.14 */
+    static int16_t sine(uint16_t angle);
+
+
+    inline static int16_t cosine(uint16_t angle)
+    {
+        return sine(angle + 0x4000);
+    }
+
+
+    /*
+     * wheelBase in mm, maxSpeed in mm/s at direction x = 1, maxSteering
+     * in radians at direction y = 1; positive y turns counter-clockwise.
+     */
+    explicit Odometry(MovementController *controller, float wheelBase,
+            float maxSpeed, float maxSteering, unsigned long period = 20);
+
+    /* Measure distance with an encoder, tickLength mm per tick */
+    void setEncoder(WheelEncoder *encoder, float tickLength);
+    void reset();
+
+
+    inline const Pose &pose() const
+    {
+        return mPose;
+    }
+
+
+    /*
+     * Return the motion since the previous moved() emission, expressed in
+     * the robot frame at that emission (x forward, y left).
+     */
+    inline const Pose &delta() const
+    {
+        return mDelta;
+    }
+
+};
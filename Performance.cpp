@@ -2,48 +2,150 @@
 #include "Arduino.h"
 
 #include "Debug.hpp"
+#include "Memory.hpp"
+#include "Watchdog.hpp"
 #include "Application.hpp"
 
 #include "Performance.hpp"
 
 
-const unsigned char Performance::sTickersSize = 5;
+const unsigned char Performance::sTickersSize;
+const unsigned char Performance::sBusStatsSize;
 
 
 void Performance::onLoop()
 {
-    mCounter++;
+    mLoop.mark();
+}
+
+
+void Performance::print(Logger &out, const IntervalHistogram &histogram)
+{
+    out << "us p50" << histogram.percentile(50)
+        << "p90" << histogram.percentile(90)
+        << "p99" << histogram.percentile(99)
+        << "worst" << histogram.worst()
+        << "at" << histogram.rate() << "Hz";
 }
 
 
 void Performance::onTimerExpired()
 {
-    unsigned long diff = millis() - mTimer.startTime();
 
-    debugLog() << (mCounter * 1000 / diff) << "FPS";
+    /* A report still going out keeps its place */
+
+    if (!report()->posted()) {
+        mReportLine = 0;
+        report()->post();
+    }
+}
+
+
+/*
+ * A line is longer than the transmit buffer and 9600 baud drains about a
+ * byte per millisecond, so the whole report would block the loop for over
+ * a second. Print one line into an empty buffer and come back for the next.
+ */
+void Performance::onReport()
+{
+    if (Serial.availableForWrite() < SERIAL_TX_BUFFER_SIZE - 1 ||
+            printLine(mReportLine++)) {
+        report()->post();
+    }
+}
+
+
+/* Print line number line of the report, true if more lines follow */
+bool Performance::printLine(unsigned char line)
+{
+    if (line == 0) {
+        print(debugLog() << "Loop", mLoop);
+        mLoop.reset();
+
+        return true;
+    }
+
+    line -= 1;
+
+    if (line < mLastTicker) {
+        print(debugLog() << "Ticker" << line, mTickers[line].histogram());
+        mTickers[line].histogram().reset();
+
+        return true;
+    }
+
+    line -= mLastTicker;
+
+    if (line < mBusStatsCount) {
+        const I2CBus::Stats *stats = mBusStats[line];
 
-    for (unsigned char i = 0; i < mLastTicker; i++) {
-        Ticker &ticker = mTickers[i];
+        debugLog() << "I2C device" << line << "transactions"
+                   << stats->transactions() << "nacks" << stats->nacks()
+                   << "timeouts" << stats->timeouts()
+                   << "errors" << stats->errors();
 
-        debugLog() << "Ticker" << i << "is at"
-                   << (ticker.mCounter * 1000 / diff)
-                   << "FPS"; 
-        ticker.mCounter = 0;
+        return true;
     }
 
-    mCounter = 0;
+    line -= mBusStatsCount;
+
+    Memory::Fragmentation fragmentation;
+
+    switch (line) {
+    case 0:
+        debugLog() << "I2C recoveries" << I2CBus::recoveries();
+
+        return true;
+
+    case 1:
+        debugLog() << "Slot overruns" << Watchdog::overruns()
+                   << "worst" << Watchdog::worstDuration() << "us";
+
+        return true;
+
+    case 2:
+        debugLog() << "Memory free" << (unsigned long) Memory::freeMemory()
+                   << "heap peak" << (unsigned long) Memory::heapPeak()
+                   << "stack peak" << (unsigned long) Memory::stackPeak()
+                   << "live" << (unsigned long) Memory::live();
+
+        return true;
+
+    case 3:
+        Memory::fragmentation(&fragmentation);
+
+        debugLog() << "Free list" << (unsigned long) fragmentation.free
+                   << "in" << fragmentation.blocks
+                   << "blocks, largest" << (unsigned long) fragmentation.largest;
+
+        return true;
+    }
+
+    line -= 4;
+
+    if (line < Memory::SubsystemsCount) {
+        debugLog() << "Subsystem" << line << "allocated"
+                   << Memory::allocations(line) << "times"
+                   << Memory::bytes(line) << "bytes";
+    }
+
+    return line + 1 < Memory::SubsystemsCount;
 }
 
 
 Performance::Performance(unsigned long timeFrame)
     : EventObject(),
     mTimer(timeFrame),
-    mCounter(0),
-    mTickers(new Ticker[sTickersSize]),
-    mLastTicker(0)
+    mLastTicker(0),
+    mBusStatsCount(0),
+    mReportLine(0)
 {
+
     EventObjectConnect(Application::instance(), loop, this, onLoop);
     EventObjectConnect(&mTimer, expired, this, onTimerExpired);
+    EventObjectConnect(this, report, this, onReport);
+
+    report()->setPriority(EventEmitter::Low);
 
     mTimer.start();
 }
@@ -55,3 +157,11 @@ Performance::Ticker *Performance::createTicker()
 
     return &mTickers[mLastTicker++];
 }
+
+
+void Performance::addBusStats(const I2CBus::Stats *stats)
+{
+    debugAssert(mBusStatsCount < sBusStatsSize);
+
+    mBusStats[mBusStatsCount++] = stats;
+}
@@ -3,45 +3,67 @@
 
 
 #include "EventObject.hpp"
+#include "I2CBus.hpp"
+#include "IntervalHistogram.hpp"
 #include "Timer.hpp"
 
 
+class Logger;
+
+
+/*
+ * Reports every timeFrame ms the loop-to-loop period and the period of
+ * each Ticker as percentiles of an IntervalHistogram, with the worst
+ * interval and the rate, then starts a new window. The counters of every
+ * I2CBus::Stats added are reported too, as totals since boot. The report
+ * goes out one line per dispatch, each once the serial transmit buffer
+ * has drained, so the loop never waits on more than the tail of a line.
+ */
 class Performance : public EventObject
 {
 
+    EVENT_OBJECT_SIGNAL(Performance, report);
+
     EVENT_OBJECT_SLOT(Performance, onLoop);
     EVENT_OBJECT_SLOT(Performance, onTimerExpired);
+    EVENT_OBJECT_SLOT(Performance, onReport);
 
 
-    static const unsigned char sTickersSize;
+    static const unsigned char sTickersSize = 5;
+    static const unsigned char sBusStatsSize = 4;
 
 
     Timer mTimer;
-    unsigned long mCounter;
+    IntervalHistogram mLoop;
     unsigned char mLastTicker;
+    const I2CBus::Stats *mBusStats[sBusStatsSize];
+    unsigned char mBusStatsCount;
+    unsigned char mReportLine;
+
+
+    static void print(Logger &out, const IntervalHistogram &histogram);
+
+    bool printLine(unsigned char line);
 
 
 public:
 
     class Ticker
     {
-        unsigned long mCounter;
-
+        IntervalHistogram mHistogram;
 
-        friend void Performance::onTimerExpired();
 
-        
     public:
 
-        inline explicit Ticker()
-            : mCounter(0)
+        inline void tick()
         {
-
+            mHistogram.mark();
         }
 
-        inline void tick()
+
+        inline IntervalHistogram &histogram()
         {
-            mCounter++;
+            return mHistogram;
         }
 
 
@@ -51,10 +73,17 @@ public:
     explicit Performance(unsigned long timeFrame = 10000);
 
     Ticker *createTicker();
+    void addBusStats(const I2CBus::Stats *stats);
+
+
+    inline const IntervalHistogram &loopHistogram() const
+    {
+        return mLoop;
+    }
 
 
 private:
 
-    Ticker *mTickers;
+    Ticker mTickers[sTickersSize];
 
 };
@@ -0,0 +1,170 @@
+#pragma once
+
+
+#include "Arduino.h"
+
+#include "SafeCounter.hpp"
+
+
+/*
+ * Stackless coroutine state for drivers written as linear "write, wait,
+ * read" sequences. The task is an ordinary member function returning
+ * bool that is re-entered from the top on every resume, normally from a
+ * permanently connected Timer::expired slot, and switch()es to the line
+ * it last waited on. Locals do not survive a wait; keep them in members.
+ *
+ *     bool Driver::task()
+ *     {
+ *         PT_BEGIN(&mTask);
+ *         writeReg(START, 0x01);
+ *         PT_WAIT_UNTIL_OR_TIMEOUT(&mTask, readReg(STATUS) & 0x01, 100);
+ *         if (mTask.expired()) PT_EXIT(&mTask);
+ *         PT_END(&mTask);
+ *     }
+ *
+ * The task returns false while it is waiting and true once it has
+ * finished. Timeouts are kept in 16 bits of millis(), so a single wait
+ * must stay below half a minute. Keep one wait per source line and do
+ * not wait inside a switch statement.
+ */
+class Protothread
+{
+
+    uint16_t mLine;
+    SafeCounter<uint16_t> mDeadline;
+    bool mExpired:1;
+    bool mBounded:1;
+
+
+public:
+
+    inline Protothread()
+        : mLine(0),
+        mExpired(false),
+        mBounded(false)
+    {
+    }
+
+
+    inline void restart()
+    {
+        mLine = 0;
+    }
+
+
+    inline bool running() const
+    {
+        return mLine != 0;
+    }
+
+
+    inline uint16_t line() const
+    {
+        return mLine;
+    }
+
+
+    inline void setLine(uint16_t value)
+    {
+        mLine = value;
+    }
+
+
+    /*
+     * A timeout of 0 never expires, matching the io_timeout convention of
+     * the drivers.
+     */
+    inline void setTimeout(uint16_t timeout)
+    {
+        mDeadline.setValue((uint16_t) millis() + timeout);
+        mExpired = false;
+        mBounded = timeout != 0;
+    }
+
+
+    inline bool timedOut() const
+    {
+        return mBounded &&
+            mDeadline.reachedAt(SafeCounter<uint16_t>(millis()));
+    }
+
+
+    /*
+     * Latches timedOut() so the task can tell, after a
+     * PT_WAIT_UNTIL_OR_TIMEOUT(), which of the two ended the wait.
+     */
+    inline bool expire()
+    {
+        mExpired = timedOut();
+
+        return mExpired;
+    }
+
+
+    inline bool expired() const
+    {
+        return mExpired;
+    }
+
+
+};
+
+
+#define PT_BEGIN(pt)                                                        \
+    switch ((pt)->line()) {                                                 \
+    case 0:
+
+
+/* The case label of a wait is entered both by falling through and by resuming */
+#if defined(__GNUC__) && __GNUC__ >= 7
+#    define PT_FALLTHROUGH __attribute__((fallthrough))
+#else
+#    define PT_FALLTHROUGH
+#endif
+
+
+#define PT_WAIT_UNTIL(pt, condition)                                        \
+    do {                                                                    \
+        (pt)->setLine(__LINE__);                                            \
+        PT_FALLTHROUGH;                                                     \
+    case __LINE__:                                                          \
+        if (!(condition)) {                                                 \
+            return false;                                                   \
+        }                                                                   \
+    } while (0)
+
+
+#define PT_WAIT_UNTIL_OR_TIMEOUT(pt, condition, timeout)                    \
+    do {                                                                    \
+        (pt)->setTimeout(timeout);                                          \
+        PT_WAIT_UNTIL(pt, (condition) || (pt)->expire());                   \
+    } while (0)
+
+
+#define PT_SLEEP(pt, timeout)                                               \
+    do {                                                                    \
+        (pt)->setTimeout(timeout);                                          \
+        PT_WAIT_UNTIL(pt, (pt)->timedOut());                                \
+    } while (0)
+
+
+#define PT_YIELD(pt)                                                        \
+    do {                                                                    \
+        (pt)->setLine(__LINE__);                                            \
+        return false;                                                       \
+    case __LINE__:                                                          \
+        ;                                                                   \
+    } while (0)
+
+
+#define PT_EXIT(pt)                                                         \
+    do {                                                                    \
+        (pt)->restart();                                                    \
+        return true;                                                        \
+    } while (0)
+
+
+#define PT_END(pt)                                                          \
+    }                                                                       \
+    (pt)->restart();                                                        \
+    return true
@@ -66,7 +66,7 @@ public:
     }
 
 
-    inline void insert(const T &item)
+    inline QueueNode<T> *insert(const T &item)
     {
         QueueNode<T> *node = new QueueNode<T>(item);
 
@@ -74,6 +74,22 @@ public:
         node->prev = head()->prev;
         node->prev->next = node;
         head()->prev = node;
+
+        return node;
+    }
+
+
+    /* Take a node of this queue out of it; the caller deletes it */
+    inline static void unlink(QueueNode<T> *node)
+    {
+        node->prev->next = node->next;
+        node->next->prev = node->prev;
+    }
+
+
+    inline bool empty()
+    {
+        return head()->next == head();
     }
 
 
@@ -0,0 +1,95 @@
+#include <math.h>
+
+#include "Arduino.h"
+
+#include "RangeSensor.hpp"
+
+
+void RangeSensor::writeSample(uint16_t range, unsigned char status)
+{
+    RangeSample *sample = mSample;
+
+    sample->time = millis();
+    sample->status = status;
+
+    if (range > maximum()) {
+        sample->range = -1;
+        sample->distance = INFINITY;
+    } else {
+        sample->range = range;
+        sample->distance = range;
+    }
+
+    if (mStopDistance == 0) {
+        return;
+    }
+
+    if (status != RangeSignalFail) {
+        mLost = false;
+    } else if (!mLost) {
+        mLost = true;
+        mLostSince = sample->time;
+    }
+
+    /*
+     * A valid reading past the hysteresis ends the stop. A lost return
+     * may as well be an obstacle too dark to range, so it only does once
+     * nothing has come back for LostReleaseTime: with open space ahead
+     * the stop would hold forever otherwise.
+     */
+
+    bool obstacle = mObstacle ?
+        !((status == RangeValid &&
+                range > mStopDistance + mStopDistance / 8) ||
+            (mLost && sample->time - mLostSince >= LostReleaseTime)) :
+        (status == RangeValid && range <= mStopDistance) ||
+            status == RangeMinRangeFail;
+
+    if (obstacle != mObstacle) {
+        mObstacle = obstacle;
+        obstacleChanged()->emit();
+    }
+}
+
+
+RangeSensor::RangeSensor()
+    : EventObject(),
+    mSample(&mOwnSample),
+    mStopDistance(0),
+    mObstacle(false),
+    mLost(false),
+    mLostSince(0)
+{
+    rangeReady()->setPriority(EventEmitter::High);
+    rangeError()->setPriority(EventEmitter::High);
+
+    setSample(nullptr);
+}
+
+
+/*
+ * Redirect samples into external storage, typically one slot of a table
+ * owned by the consumer. Passing nullptr reverts to the sensor's own slot.
+ */
+void RangeSensor::setSample(RangeSample *value)
+{
+    RangeSample *sample = value == nullptr ? &mOwnSample : value;
+
+    sample->distance = INFINITY;
+    sample->time = 0;
+    sample->range = -1;
+    sample->status = RangeNone;
+
+    mSample = sample;
+}
+
+
+void RangeSensor::setStopDistance(uint16_t value)
+{
+    mStopDistance = value;
+
+    if (value == 0 && mObstacle) {
+        mObstacle = false;
+        obstacleChanged()->emit();
+    }
+}
@@ -1,4 +1,3 @@
-
 #pragma once
 
 
@@ -7,6 +6,19 @@
 #include "EventObject.hpp"
 
 
+/*
+ * One measurement as written in place by a RangeSensor driver. Consumers
+ * read it as is: distance is already converted and saturated at write time.
+ */
+struct RangeSample
+{
+    float distance;         /* mm, INFINITY when nothing is in range */
+    unsigned long time;     /* millis() when the sample was read */
+    uint16_t range;         /* mm, -1 when nothing is in range */
+    unsigned char status;   /* RangeSensor::RangeStatus */
+};
+
+
 class RangeSensor : public EventObject
 {
 
@@ -15,13 +27,115 @@ class RangeSensor : public EventObject
     EVENT_OBJECT_SIGNAL(RangeSensor, rangeError);
     EVENT_OBJECT_SIGNAL(RangeSensor, rangeReady);
 
+    /* Emitted, not posted, from writeSample() */
+    EVENT_OBJECT_SIGNAL(RangeSensor, obstacleChanged);
+
+
+    RangeSample mOwnSample;
+    RangeSample *mSample;
+
+    uint16_t mStopDistance;
+    bool mObstacle;
+
+    bool mLost;
+
+    /* millis() of the first of consecutive lost returns */
+    unsigned long mLostSince;
+
+
+protected:
+
+    void writeSample(uint16_t range, unsigned char status);
+
 
 public:
 
+    enum RangeStatus
+    {
+        RangeValid,
+        RangeSignalFail,
+        RangeMinRangeFail,
+        RangePhaseFail,
+        RangeHardwareFail,
+        RangeNone
+    };
+
+
+    /*
+     * Ordered power levels. Idle ranges at a reduced rate, Standby keeps
+     * the configuration but stops ranging, Off cuts the sensor entirely
+     * and costs a re-init to come back from.
+     */
+    enum Power
+    {
+        PowerOff,
+        PowerStandby,
+        PowerIdle,
+        PowerActive
+    };
+
+
+    /* ms without any return before a stop is released */
+    static const unsigned long LostReleaseTime = 1000;
+
+
+    explicit RangeSensor();
+
     virtual void start() = 0;
     virtual void reinit() = 0;
-    virtual uint16_t range() const = 0;
     virtual uint16_t delta() const = 0;
     virtual uint16_t maximum() const = 0;
 
+    /* Return signal and ambient rates in MCPS, 9.7 fixed point */
+    virtual uint16_t signalRate() const = 0;
+    virtual uint16_t ambientRate() const = 0;
+
+    /*
+     * Move to a RangeSensor::Power level. Takes effect once started and
+     * may be degraded by the driver, see power().
+     */
+    virtual void setPower(unsigned char value) = 0;
+    virtual unsigned char power() const = 0;
+
+    void setSample(RangeSample *value);
+
+    /*
+     * Report an obstacle as soon as a sample comes in at or below value
+     * mm (or too close to range at all), and its clearance once a valid
+     * sample exceeds value by an eighth or the return has stayed lost for
+     * LostReleaseTime. 0 disables the check.
+     */
+    void setStopDistance(uint16_t value);
+
+
+    inline uint16_t stopDistance() const
+    {
+        return mStopDistance;
+    }
+
+
+    inline bool obstacle() const
+    {
+        return mObstacle;
+    }
+
+
+
+    inline const RangeSample &sample() const
+    {
+        return *mSample;
+    }
+
+
+    inline uint16_t range() const
+    {
+        return mSample->range;
+    }
+
+
+    inline unsigned char rangeStatus() const
+    {
+        return mSample->status;
+    }
+
 };
@@ -1,4 +1,6 @@
 
+#include <math.h>
+
 #include "Arduino.h"
 
 #include "Debug.hpp"
@@ -19,6 +21,12 @@ void RickshawController::onStarted()
 }
 
 
+void RickshawController::onSpeedOutputChanged()
+{
+    analogWrite(mPwmPin, mSpeedController->output());
+}
+
+
 void RickshawController::writeIdle()
 {
     analogWrite(mPwmPin, 0);
@@ -29,9 +37,10 @@ void RickshawController::writeIdle()
 }
 
 
+/* y > 0 steers to the left end stop, y < 0 to the right one */
 unsigned char RickshawController::servoAngle(float y) const
 {
-    return (float) servoMiddleAngle() + y * mServoFactors[y > 0];
+    return (float) servoMiddleAngle() + fabs(y) * mServoFactors[y < 0];
 }
 
 
@@ -41,7 +50,9 @@ RickshawController::RickshawController(unsigned char pwmPin,
     mPwmPin(pwmPin),
     mFwdPin(fwdPin),
     mBwdPin(bwdPin),
-    mServoPin(servoPin)
+    mServoPin(servoPin),
+    mSpeedController(nullptr),
+    mMaxSpeed(0)
 {
     EventObjectConnect(Application::instance(), started, this, onStarted);
 
@@ -50,15 +61,24 @@ RickshawController::RickshawController(unsigned char pwmPin,
 }
 
 
-void RickshawController::setDirection(const Vector2f &value)
+void RickshawController::writeDirection(const Vector2f &value)
 {
-    MovementController::setDirection(value);
-
     bool isForward = value.x() > 0;
 
     digitalWrite(mFwdPin, isForward);
     digitalWrite(mBwdPin, !isForward);
-    analogWrite(mPwmPin, (float) maxMotorDutyCycle() * value.x());
+
+    if (mSpeedController != nullptr && value.x() == 0 && inhibited() != 0) {
+
+        /* Stopped by an inhibit: cut the drive instead of braking by PID */
+
+        mSpeedController->reset();
+        analogWrite(mPwmPin, 0);
+    } else if (mSpeedController != nullptr) {
+        mSpeedController->setTarget(fabs(value.x()) * mMaxSpeed);
+    } else {
+        analogWrite(mPwmPin, (float) maxMotorDutyCycle() * fabs(value.x()));
+    }
 
     mServo.write(servoAngle(value.y()));
 }
@@ -76,3 +96,22 @@ void RickshawController::setServoAngles(unsigned char left,
     mServoFactors[0] = (float) left - middlef;
     mServoFactors[1] = (float) right - middlef;
 }
+
+
+void RickshawController::setSpeedController(SpeedController *controller,
+        float maxSpeed)
+{
+    if (mSpeedController != nullptr) {
+        EventObjectDisconnect(mSpeedController, outputChanged, this,
+                onSpeedOutputChanged);
+    }
+
+    mSpeedController = controller;
+    mMaxSpeed = maxSpeed;
+
+    if (controller != nullptr) {
+        controller->reset();
+        EventObjectConnect(controller, outputChanged, this,
+                onSpeedOutputChanged);
+    }
+}
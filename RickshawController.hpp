@@ -5,12 +5,14 @@
 #include <Servo.h>
 
 #include "MovementController.hpp"
+#include "SpeedController.hpp"
 
 
 class RickshawController : public MovementController
 {
 
     EVENT_OBJECT_SLOT(RickshawController, onStarted);
+    EVENT_OBJECT_SLOT(RickshawController, onSpeedOutputChanged);
 
 
     const unsigned char mPwmPin;
@@ -20,6 +22,9 @@ class RickshawController : public MovementController
 
     unsigned char mMaxMotorDutyCycle;
 
+    SpeedController *mSpeedController;
+    float mMaxSpeed;
+
     unsigned char mServoMiddleAngle;
     float mServoFactors[2];
 
@@ -30,13 +35,16 @@ class RickshawController : public MovementController
     unsigned char servoAngle(float y) const;
 
 
+protected:
+
+    virtual void writeDirection(const Vector2f &value) override;
+
+
 public:
 
     explicit RickshawController(unsigned char pwmPin, unsigned char fwdPin,
             unsigned char bwdPin, unsigned char servoPin);
 
-    virtual void setDirection(const Vector2f &value) override;
-
 
     inline unsigned char maxMotorDutyCycle() const
     {
@@ -44,12 +52,31 @@ public:
     }
 
 
-    inline unsigned char setMaxMotorDutyCycle(unsigned char value)
+    inline void setMaxMotorDutyCycle(unsigned char value)
     {
         mMaxMotorDutyCycle = value;
     }
 
 
+    /*
+     * Close the motor loop: direction x then commands x * maxSpeed encoder
+     * ticks per second instead of a fraction of maxMotorDutyCycle().
+     */
+    void setSpeedController(SpeedController *controller, float maxSpeed);
+
+
+    inline SpeedController *speedController() const
+    {
+        return mSpeedController;
+    }
+
+
+    inline float maxSpeed() const
+    {
+        return mMaxSpeed;
+    }
+
+
     inline unsigned char servoMiddleAngle() const
     {
         return mServoMiddleAngle;
@@ -0,0 +1,97 @@
+#include "Arduino.h"
+
+#include "Robot.hpp"
+
+
+static_assert(Robot::SensorsCount == 3,
+        "Robot::Robot() initialises the sensors one by one");
+
+
+constexpr Robot::SensorConfig Robot::Sensors[];
+
+
+/*
+ * Look further ahead at speed and sample faster when manoeuvring. The
+ * first switch to LongRange costs a phase calibration, later ones a few
+ * register writes.
+ */
+void Robot::onDirectionChanged()
+{
+    VL53L0XAsync &front = mRangeSensors[BreadthSensors::Front];
+    float speed = mController.direction().x();
+    unsigned char profile = front.profile();
+
+    if (speed > LongRangeSpeed) {
+        profile = VL53L0XAsync::LongRange;
+    } else if (speed < LongRangeSpeed * 3 / 4) {
+        profile = VL53L0XAsync::HighSpeed;
+    }
+
+    if (profile != front.profile()) {
+        front.setProfile(profile);
+        mBreadthSensors.updateLimits();
+    }
+}
+
+
+void Robot::onSensorsReady()
+{
+    mSensorsTicker->tick();
+}
+
+
+#if ROBOT_OFFBOARD_PLANNER
+void Robot::onPlannerDirection()
+{
+    mController.lerpDirectionTo(mLink.direction(), mLink.lerpTime());
+}
+#endif
+
+
+Robot::Robot()
+    : EventObject(),
+    mRangeSensors{
+        { Sensors[0].xshutPin, Sensors[0].address },
+        { Sensors[1].xshutPin, Sensors[1].address },
+        { Sensors[2].xshutPin, Sensors[2].address }
+    },
+    mBreadthSensors(BodyWidth, BodyLength),
+#if ROBOT_DRIVETRAIN
+    mEncoder(EncoderPin),
+    mSpeedController(&mEncoder),
+    mController(MotorPwmPin, MotorForwardPin, MotorBackwardPin, ServoPin),
+#else
+    mController(),
+#endif
+    mSafeStop(&mController),
+    mOdometry(&mController, WheelBase, MaxSpeed, MaxSteering),
+#if ROBOT_OFFBOARD_PLANNER
+    mLink(&Serial1, &mBreadthSensors),
+#else
+    mHeuristics(&mBreadthSensors, &mController),
+#endif
+    mSensorPower(&mBreadthSensors, &mController),
+    mPerformance(),
+    mSensorsTicker(mPerformance.createTicker())
+{
+    for (unsigned char i = 0; i < SensorsCount; i++) {
+        mBreadthSensors.setSensor(i, &mRangeSensors[i]);
+        mSafeStop.addSensor(&mRangeSensors[i],
+                MovementController::InhibitForward, StopDistance);
+        mPerformance.addBusStats(&mRangeSensors[i].busStats());
+    }
+
+#if ROBOT_DRIVETRAIN
+    mSpeedController.setMaxOutput(MaxMotorDutyCycle);
+    mController.setSpeedController(&mSpeedController,
+            MaxSpeed / EncoderTickLength);
+    mOdometry.setEncoder(&mEncoder, EncoderTickLength);
+#endif
+
+    EventObjectConnect(&mBreadthSensors, ready, this, onSensorsReady);
+    EventObjectConnect(&mController, directionChanged, this,
+            onDirectionChanged);
+#if ROBOT_OFFBOARD_PLANNER
+    EventObjectConnect(&mLink, directionReceived, this, onPlannerDirection);
+#endif
+}
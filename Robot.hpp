@@ -0,0 +1,216 @@
+#pragma once
+
+
+#include "Arduino.h"
+
+#include "BasicMovementHeuristics.hpp"
+#include "BreadthSensors.hpp"
+#include "EventObject.hpp"
+#include "Link.hpp"
+#include "Odometry.hpp"
+#include "Performance.hpp"
+#include "RickshawController.hpp"
+#include "SafeStop.hpp"
+#include "SensorPower.hpp"
+#include "SpeedController.hpp"
+#include "VL53L0XAsync.hpp"
+#include "WheelEncoder.hpp"
+
+
+/*
+ * Set to 1 to drive the motor and steering servo on the Motor*Pin and
+ * ServoPin below, with the motor speed closed through the wheel encoder
+ * on EncoderPin. Those pins are not taken from a recorded wiring yet, so
+ * the drivetrain is off by default: the heuristics and SafeStop then
+ * command a bare MovementController, which keeps the direction but
+ * writes no pins.
+ */
+#ifndef ROBOT_DRIVETRAIN
+#    define ROBOT_DRIVETRAIN 0
+#endif
+
+
+/*
+ * Set to 1 to steer from an off-board planner on Serial1 (see Link)
+ * instead of BasicMovementHeuristics. SafeStop stays on board either way.
+ */
+#ifndef ROBOT_OFFBOARD_PLANNER
+#    define ROBOT_OFFBOARD_PLANNER 0
+#endif
+
+
+/*
+ * The whole robot as one object graph, wired by the constructor and meant
+ * for static storage: nothing below is allocated at boot besides the
+ * emitters' connection lists, and avr-size reports the footprint at link
+ * time. The sensors are held as VL53L0XAsync (final), so calls made
+ * through them here are direct.
+ */
+class Robot : public EventObject
+{
+
+    EVENT_OBJECT_SLOT(Robot, onDirectionChanged);
+    EVENT_OBJECT_SLOT(Robot, onSensorsReady);
+#if ROBOT_OFFBOARD_PLANNER
+    EVENT_OBJECT_SLOT(Robot, onPlannerDirection);
+#endif
+
+
+public:
+
+#if ROBOT_DRIVETRAIN
+    typedef RickshawController Drivetrain;
+#else
+    typedef MovementController Drivetrain;
+#endif
+
+
+    struct SensorConfig
+    {
+        unsigned char xshutPin;
+        unsigned char address;
+
+        /*
+         * Mounting pose from the centre of the body: mm forward, mm to
+         * the left and degrees counterclockwise from straight ahead
+         */
+        float x;
+        float y;
+        float heading;
+    };
+
+
+    static constexpr unsigned char SensorsCount = 3;
+
+    /* Indexed by BreadthSensors::Position */
+    static constexpr SensorConfig Sensors[SensorsCount] = {
+        { 12, 44, 125, 0, 0 },
+        { 10, 46, 115, 70, 45 },
+        { 11, 45, 115, -70, -45 }
+    };
+
+    /*
+     * Drive above which the front sensor switches to its LongRange
+     * profile, and back to HighSpeed below three quarters of it
+     */
+    static constexpr float LongRangeSpeed = 0.5;
+
+    /* Every front sensor stops forward drive at this range, mm */
+    static constexpr uint16_t StopDistance = 120;
+
+    static constexpr float BodyWidth = 160;
+    static constexpr float BodyLength = 250;
+
+    /* Axle to axle, mm, and steering at the servo end stops, radians */
+    static constexpr float WheelBase = 180;
+    static constexpr float MaxSteering = 0.52;
+
+    /* Only written with ROBOT_DRIVETRAIN */
+    static constexpr unsigned char MotorPwmPin = 5;
+    static constexpr unsigned char MotorForwardPin = 7;
+    static constexpr unsigned char MotorBackwardPin = 8;
+    static constexpr unsigned char ServoPin = 4;
+    static constexpr unsigned char EncoderPin = 2;
+
+    /* mm travelled per encoder tick, and mm/s at direction x = 1 */
+    static constexpr float EncoderTickLength = 1;
+    static constexpr float MaxSpeed = 175;
+
+    /* Duty cycle cap of the speed loop, a stalled wheel gets no more */
+    static constexpr unsigned char MaxMotorDutyCycle = 60;
+
+    static constexpr unsigned long LinkBaud = 115200;
+
+
+private:
+
+    VL53L0XAsync mRangeSensors[SensorsCount];
+    BreadthSensors mBreadthSensors;
+#if ROBOT_DRIVETRAIN
+    WheelEncoder mEncoder;
+    SpeedController mSpeedController;
+#endif
+    Drivetrain mController;
+    SafeStop mSafeStop;
+    Odometry mOdometry;
+#if ROBOT_OFFBOARD_PLANNER
+    Link mLink;
+#else
+    BasicMovementHeuristics mHeuristics;
+#endif
+    SensorPower mSensorPower;
+    Performance mPerformance;
+    Performance::Ticker *mSensorsTicker;
+
+
+public:
+
+    explicit Robot();
+
+
+    inline VL53L0XAsync &rangeSensor(unsigned char position)
+    {
+        return mRangeSensors[position];
+    }
+
+
+    inline BreadthSensors &breadthSensors()
+    {
+        return mBreadthSensors;
+    }
+
+
+    inline Drivetrain &controller()
+    {
+        return mController;
+    }
+
+
+#if ROBOT_DRIVETRAIN
+    inline WheelEncoder &encoder()
+    {
+        return mEncoder;
+    }
+
+
+    inline SpeedController &speedController()
+    {
+        return mSpeedController;
+    }
+#endif
+
+
+    inline SafeStop &safeStop()
+    {
+        return mSafeStop;
+    }
+
+
+    /* Pose of the rear axle since boot */
+    inline Odometry &odometry()
+    {
+        return mOdometry;
+    }
+
+
+    inline SensorPower &sensorPower()
+    {
+        return mSensorPower;
+    }
+
+
+    inline Performance &performance()
+    {
+        return mPerformance;
+    }
+
+
+#if ROBOT_OFFBOARD_PLANNER
+    inline Link &link()
+    {
+        return mLink;
+    }
+#endif
+
+
+};
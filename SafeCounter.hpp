@@ -1,26 +1,73 @@
-
 #pragma once
 
 
+#include <stdint.h>
+
+
+template<typename T>
+class SafeCounterTraits;
+
+
+template<>
+class SafeCounterTraits<uint8_t>
+{
+
+public:
+
+    typedef int8_t Signed;
+
+};
+
+
+template<>
+class SafeCounterTraits<uint16_t>
+{
+
+public:
+
+    typedef int16_t Signed;
+
+};
+
+
+template<>
+class SafeCounterTraits<unsigned long>
+{
+
+public:
+
+    typedef long Signed;
+
+};
+
+
+/*
+ * Free running unsigned counter compared modulo its range: a is before b
+ * when b - a, as a signed value, is positive. That holds across the
+ * wraparound as long as the two are less than half the range apart,
+ * and costs one subtraction and a sign test instead of branching on
+ * which of the two has wrapped.
+ */
 template<typename T>
 class SafeCounter
 {
 
     T mValue;
-    T mDelta;
 
 
 public:
 
-    inline explicit SafeCounter(const T value, const T delta)
-        : mValue(value),
-        mDelta(delta)
+    typedef typename SafeCounterTraits<T>::Signed Signed;
+
+
+    inline constexpr explicit SafeCounter(const T value = 0)
+        : mValue(value)
     {
 
     }
 
 
-    inline T value() const
+    inline constexpr T value() const
     {
         return mValue;
     }
@@ -32,27 +79,68 @@ public:
     }
 
 
-    inline T delta() const
+    /* Distance from earlier to this, earlier must not be after this */
+    inline constexpr T since(const SafeCounter &earlier) const
+    {
+        return mValue - earlier.mValue;
+    }
+
+
+    /* Signed distance from other to this */
+    inline constexpr Signed compare(const SafeCounter &other) const
     {
-        return mDelta;
+        return (Signed) (T) (mValue - other.mValue);
     }
 
 
-    inline void setDelta(const T value)
+    inline constexpr bool before(const SafeCounter &other) const
     {
-        mDelta = value;
+        return compare(other) < 0;
     }
 
 
-    bool operator <=(const T value)
+    inline constexpr bool after(const SafeCounter &other) const
     {
-        T result = mValue + mDelta;
+        return compare(other) > 0;
+    }
+
+
+    /* Whether this, as a deadline, has been reached at time now */
+    inline constexpr bool reachedAt(const SafeCounter &now) const
+    {
+        return now.compare(*this) >= 0;
+    }
+
+
+    inline constexpr SafeCounter operator +(const T delta) const
+    {
+        return SafeCounter(mValue + delta);
+    }
 
-        if (result < mValue) {
-            return mValue >= value && result <= value;
-        }
 
-        return result <= value;
+    inline constexpr SafeCounter operator -(const T delta) const
+    {
+        return SafeCounter(mValue - delta);
+    }
+
+
+    inline SafeCounter &operator +=(const T delta)
+    {
+        mValue += delta;
+
+        return *this;
+    }
+
+
+    inline constexpr bool operator ==(const SafeCounter &other) const
+    {
+        return mValue == other.mValue;
+    }
+
+
+    inline constexpr bool operator !=(const SafeCounter &other) const
+    {
+        return mValue != other.mValue;
     }
 
 };
@@ -0,0 +1,51 @@
+#include "Debug.hpp"
+
+#include "SafeStop.hpp"
+
+
+void SafeStop::onObstacleChanged()
+{
+    unsigned char mask = 0;
+    unsigned char previous = mController->inhibited();
+
+    for (unsigned char i = 0; i < mCount; i++) {
+        if (mSensors[i]->obstacle()) {
+            mask |= mInhibits[i];
+        }
+    }
+
+    if (mask == previous) {
+        return;
+    }
+
+    mController->setInhibited(mask);
+
+    if ((mask & ~previous) != 0) {
+        mTriggers++;
+        triggered()->post();
+    }
+}
+
+
+SafeStop::SafeStop(MovementController *controller)
+    : EventObject(),
+    mController(controller),
+    mCount(0),
+    mTriggers(0)
+{
+    triggered()->setPriority(EventEmitter::Low);
+}
+
+
+void SafeStop::addSensor(RangeSensor *sensor, unsigned char inhibit,
+        uint16_t stopDistance)
+{
+    debugAssert(mCount < Capacity);
+
+    mSensors[mCount] = sensor;
+    mInhibits[mCount] = inhibit;
+    mCount++;
+
+    sensor->setStopDistance(stopDistance);
+    EventObjectConnect(sensor, obstacleChanged, this, onObstacleChanged);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+
+#include "EventObject.hpp"
+#include "MovementController.hpp"
+#include "RangeSensor.hpp"
+
+
+/*
+ * Reflex that stops the drive without waiting for the planner. Each
+ * guarded sensor checks its stop distance in writeSample() and emits
+ * obstacleChanged synchronously, so the inhibit reaches the motor from
+ * within the slot that read the sample rather than after the
+ * BreadthSensors aggregation and a planner pass. triggered is posted
+ * afterwards for whoever wants to know.
+ */
+class SafeStop : public EventObject
+{
+
+    EVENT_OBJECT_SIGNAL(SafeStop, triggered);
+
+    EVENT_OBJECT_SLOT(SafeStop, onObstacleChanged);
+
+
+public:
+
+    static const unsigned char Capacity = 8;
+
+
+private:
+
+    MovementController * const mController;
+
+    RangeSensor *mSensors[Capacity];
+    unsigned char mInhibits[Capacity];
+    unsigned char mCount;
+
+    unsigned long mTriggers;
+
+
+public:
+
+    explicit SafeStop(MovementController *controller);
+
+    /* Inhibit the given MovementController::Inhibit directions */
+    void addSensor(RangeSensor *sensor, unsigned char inhibit,
+            uint16_t stopDistance);
+
+
+    inline unsigned char inhibited() const
+    {
+        return mController->inhibited();
+    }
+
+
+    inline unsigned long triggers() const
+    {
+        return mTriggers;
+    }
+
+
+};
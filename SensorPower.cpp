@@ -0,0 +1,124 @@
+#include <math.h>
+
+#include "SensorPower.hpp"
+
+
+const unsigned long SensorPower::EvalPeriod = 100;
+const unsigned long SensorPower::StandbyDelay = 1000;
+const unsigned long SensorPower::OffDelay = 10000;
+
+
+unsigned char SensorPower::wanted(unsigned char index,
+        const Vector2f &direction) const
+{
+    float speed = direction.x();
+
+    if (!mEnabled) {
+        return RangeSensor::PowerActive;
+    }
+
+    if (speed < -ParkSpeed) {
+        return RangeSensor::PowerIdle;
+    }
+
+    if (index == BreadthSensors::Front) {
+        return speed > ParkSpeed ? RangeSensor::PowerActive :
+            RangeSensor::PowerIdle;
+    }
+
+    if (speed > SlowSpeed || fabs(direction.y()) > SteerThreshold) {
+        return RangeSensor::PowerActive;
+    }
+
+    return speed > ParkSpeed ? RangeSensor::PowerIdle : RangeSensor::PowerOff;
+}
+
+
+void SensorPower::update(bool lower)
+{
+    Vector2f direction = mController->direction();
+    Timestamp<MillisClock> now = Timestamp<MillisClock>::now();
+
+    for (unsigned char i = 0; i < mSensors->samplesCount(); i++) {
+        RangeSensor *sensor = mSensors->sensor(i);
+
+        if (sensor == nullptr) {
+            continue;
+        }
+
+        unsigned char level = wanted(i, direction);
+        unsigned char current = sensor->power();
+
+        if (sensor->obstacle() && level < RangeSensor::PowerIdle) {
+            level = RangeSensor::PowerIdle;
+        }
+
+        if (level >= current) {
+            mWanted[i] = now;
+
+            if (level > current) {
+                mSensors->setPower(i, level);
+            }
+
+            continue;
+        }
+
+        if (!lower) {
+            continue;
+        }
+
+        Duration<MillisClock> unwanted = now - mWanted[i];
+
+        if (unwanted < Duration<MillisClock>(StandbyDelay)) {
+            continue;
+        }
+
+        if (unwanted < Duration<MillisClock>(OffDelay) &&
+                level < RangeSensor::PowerStandby) {
+            level = RangeSensor::PowerStandby;
+        }
+
+        if (level < current) {
+            mSensors->setPower(i, level);
+        }
+    }
+}
+
+
+/*
+ * directionChanged is emitted from within SafeStop, and so from within a
+ * sensor's own sample; only raise levels there and leave stopping a
+ * sensor to the timer.
+ */
+void SensorPower::onDirectionChanged()
+{
+    update(false);
+}
+
+
+void SensorPower::onTimerExpired()
+{
+    update(true);
+}
+
+
+SensorPower::SensorPower(BreadthSensors *sensors,
+        MovementController *controller)
+    : EventObject(),
+    mSensors(sensors),
+    mController(controller),
+    mTimer(EvalPeriod),
+    mEnabled(true)
+{
+    EventObjectConnect(controller, directionChanged, this, onDirectionChanged);
+    EventObjectConnect(&mTimer, expired, this, onTimerExpired);
+
+    mTimer.start();
+}
+
+
+void SensorPower::setEnabled(bool value)
+{
+    mEnabled = value;
+    update(true);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+
+#include "BreadthSensors.hpp"
+#include "EventObject.hpp"
+#include "MovementController.hpp"
+#include "Time.hpp"
+#include "Timer.hpp"
+#include "Vector2f.hpp"
+
+
+/*
+ * Power policy for the BreadthSensors, driven by the direction of the
+ * MovementController (x drives, y steers). While driving forward the
+ * front sensor ranges at full rate and the side sensors join it when
+ * driving fast or steering, idling otherwise. Reversing idles them all,
+ * since none of them looks where the robot goes. Once parked the front
+ * sensor idles and the sides go to standby, then XSHUT off.
+ *
+ * A level is raised as soon as it is wanted, from within
+ * directionChanged, and lowered only once it has not been wanted for
+ * StandbyDelay, or OffDelay for PowerOff, so that stop and go does not
+ * churn re-inits. A sensor that holds an obstacle never drops below
+ * PowerIdle, or the obstacle could never clear.
+ */
+class SensorPower : public EventObject
+{
+
+    EVENT_OBJECT_SLOT(SensorPower, onDirectionChanged);
+    EVENT_OBJECT_SLOT(SensorPower, onTimerExpired);
+
+
+public:
+
+    /* Fractions of full drive and steering */
+    static constexpr float ParkSpeed = 0.02;
+    static constexpr float SlowSpeed = 0.25;
+    static constexpr float SteerThreshold = 0.2;
+
+    /* Milliseconds */
+    static const unsigned long EvalPeriod;
+    static const unsigned long StandbyDelay;
+    static const unsigned long OffDelay;
+
+
+private:
+
+    BreadthSensors * const mSensors;
+    MovementController * const mController;
+    Timer mTimer;
+
+    /* When each sensor was last wanted at its current level or above */
+    Timestamp<MillisClock> mWanted[BreadthSensors::Capacity];
+
+    bool mEnabled;
+
+
+    unsigned char wanted(unsigned char index, const Vector2f &direction) const;
+    void update(bool lower);
+
+
+public:
+
+    explicit SensorPower(BreadthSensors *sensors,
+            MovementController *controller);
+
+    /* A disabled policy keeps every sensor at PowerActive */
+    void setEnabled(bool value);
+
+
+    inline bool enabled() const
+    {
+        return mEnabled;
+    }
+
+
+};
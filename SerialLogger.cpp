@@ -67,6 +67,9 @@ Logger & SerialLogger::operator<<(unsigned long value)
 }
 
 
+#if LOGGER_HAS_SIZE_T
+
+
 Logger & SerialLogger::operator<<(size_t value)
 {
     Serial.write(" ");
@@ -76,6 +79,9 @@ Logger & SerialLogger::operator<<(size_t value)
 }
 
 
+#endif
+
+
 Logger & SerialLogger::operator<<(const char *value)
 {
     Serial.write(" ");
@@ -22,7 +22,9 @@ public:
     virtual Logger & operator<<(double value) override;
     virtual Logger & operator<<(bool value) override;
     virtual Logger & operator<<(unsigned long value) override;
+#if LOGGER_HAS_SIZE_T
     virtual Logger & operator<<(size_t value) override;
+#endif
     virtual Logger & operator<<(const char *value) override;
 
 };
@@ -0,0 +1,117 @@
+#include "Arduino.h"
+
+#include "Debug.hpp"
+#include "Application.hpp"
+
+#include "SpeedController.hpp"
+
+
+#define SPEED_CONTROLLER_INTEGRAL_LIMIT (1L << 20)
+
+
+void SpeedController::onTimerExpired()
+{
+    /* Ticks per period, also when the loop made us miss some */
+    mMeasured = ((int32_t) mEncoder->takeTicks() << 8) /
+        (int32_t) mTimer.coalesced();
+
+    if (mTarget == 0) {
+        mIntegral = 0;
+        mLastError = 0;
+
+        if (mOutput != 0) {
+            mOutput = 0;
+            outputChanged()->emit();
+        }
+
+        return;
+    }
+
+    int32_t error = mTarget - mMeasured;
+    int32_t output = mKp * error + mKd * (error - mLastError);
+
+    mLastError = error;
+
+    /* Conditional integration: stop winding up against a saturated output */
+    int32_t integral = mIntegral + error;
+
+    if (integral > SPEED_CONTROLLER_INTEGRAL_LIMIT) {
+        integral = SPEED_CONTROLLER_INTEGRAL_LIMIT;
+    } else if (integral < -SPEED_CONTROLLER_INTEGRAL_LIMIT) {
+        integral = -SPEED_CONTROLLER_INTEGRAL_LIMIT;
+    }
+
+    output = (output + mKi * (integral >> 4)) >> 12;
+
+    if (output > mMaxOutput) {
+        output = mMaxOutput;
+    } else if (output < 0) {
+        output = 0;
+    }
+
+    if ((output > 0 || error > 0) && (output < mMaxOutput || error < 0)) {
+        mIntegral = integral;
+    }
+
+    if (output != mOutput) {
+        mOutput = output;
+        outputChanged()->emit();
+    }
+}
+
+
+SpeedController::SpeedController(WheelEncoder *encoder, unsigned long period)
+    : EventObject(),
+    mEncoder(encoder),
+    mTimer(period),
+    mIntegral(0),
+    mTarget(0),
+    mMeasured(0),
+    mLastError(0),
+    mKp(0),
+    mKi(0),
+    mKd(0),
+    mOutput(0),
+    mMaxOutput(255)
+{
+    EventObjectConnect(&mTimer, expired, this, onTimerExpired);
+
+    setGains(2, 0.5, 0);
+
+    mTimer.start();
+}
+
+
+/*
+ * Gains map one tick per period of error to duty cycle units. Kp and Kd
+ * are stored as Q4, Ki as Q8 against an integral pre-scaled by 1/16, so
+ * all three terms land in Q12 duty cycle units.
+ */
+void SpeedController::setGains(float kp, float ki, float kd)
+{
+    mKp = kp * 16;
+    mKi = ki * 256;
+    mKd = kd * 16;
+}
+
+
+void SpeedController::setTarget(float ticksPerSecond)
+{
+    debugAssert(ticksPerSecond >= 0);
+
+    /* A 16 bit encoder count per period, in Q8, is as fast as it reads */
+
+    float target = ticksPerSecond * mTimer.timeout() * 256 / 1000;
+
+    mTarget = target < 65535L * 256 ? (int32_t) target : 65535L * 256;
+}
+
+
+void SpeedController::reset()
+{
+    mIntegral = 0;
+    mLastError = 0;
+    mTarget = 0;
+    mOutput = 0;
+    mEncoder->takeTicks();
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+
+#include <stdint.h>
+
+#include "EventObject.hpp"
+#include "Timer.hpp"
+#include "WheelEncoder.hpp"
+
+
+/*
+ * Fixed rate PID loop turning a wheel speed in encoder ticks per second
+ * into a PWM duty cycle. Speeds are kept as Q8 ticks per period in 32
+ * bits, which a 16 bit encoder count cannot overflow, and gains as fixed
+ * point, so a step is integer multiply-adds only. The encoder
+ * has a single channel, so speeds are magnitudes; the caller owns the
+ * direction of rotation.
+ */
+class SpeedController : public EventObject
+{
+
+    EVENT_OBJECT_SIGNAL(SpeedController, outputChanged);
+
+    EVENT_OBJECT_SLOT(SpeedController, onTimerExpired);
+
+
+    WheelEncoder * const mEncoder;
+    Timer mTimer;
+
+    int32_t mIntegral;
+    int32_t mTarget;
+    int32_t mMeasured;
+    int32_t mLastError;
+
+    int16_t mKp;
+    int16_t mKi;
+    int16_t mKd;
+
+    unsigned char mOutput;
+    unsigned char mMaxOutput;
+
+
+public:
+
+    explicit SpeedController(WheelEncoder *encoder, unsigned long period = 20);
+
+    void setGains(float kp, float ki, float kd);
+    void setTarget(float ticksPerSecond);
+    void reset();
+
+
+    inline unsigned char output() const
+    {
+        return mOutput;
+    }
+
+
+    inline unsigned char maxOutput() const
+    {
+        return mMaxOutput;
+    }
+
+
+    inline void setMaxOutput(unsigned char value)
+    {
+        mMaxOutput = value;
+    }
+
+
+    inline float measuredSpeed() const
+    {
+        return mMeasured * (1000.0f / 256) / mTimer.timeout();
+    }
+
+};
@@ -0,0 +1,200 @@
+#pragma once
+
+
+#include "Arduino.h"
+
+#include "SafeCounter.hpp"
+
+
+/*
+ * Typed time on top of SafeCounter. A Duration and a Timestamp carry
+ * their clock in the type, so milliseconds are never subtracted from
+ * microseconds and conversions are spelled out; to() is constexpr and
+ * compiles to a single multiply or divide. Timestamps wrap with the
+ * clock and compare modulo 2^32 (49 days of millis(), 71 minutes of
+ * micros()), Durations are plain unsigned counts.
+ */
+
+
+class MillisClock
+{
+
+public:
+
+    static const unsigned long PerSecond = 1000;
+
+
+    inline static unsigned long now()
+    {
+        return millis();
+    }
+
+};
+
+
+class MicrosClock
+{
+
+public:
+
+    static const unsigned long PerSecond = 1000000;
+
+
+    inline static unsigned long now()
+    {
+        return micros();
+    }
+
+};
+
+
+template<typename Clock>
+class Duration
+{
+
+    unsigned long mValue;
+
+
+public:
+
+    inline constexpr explicit Duration(unsigned long value = 0)
+        : mValue(value)
+    {
+
+    }
+
+
+    inline constexpr unsigned long count() const
+    {
+        return mValue;
+    }
+
+
+    template<typename To>
+    inline constexpr Duration<To> to() const
+    {
+        static_assert(To::PerSecond % Clock::PerSecond == 0 ||
+                Clock::PerSecond % To::PerSecond == 0,
+                "clock rates must divide one another");
+
+        return Duration<To>(To::PerSecond >= Clock::PerSecond ?
+                mValue * (To::PerSecond / Clock::PerSecond) :
+                mValue / (Clock::PerSecond / To::PerSecond));
+    }
+
+
+    inline constexpr Duration operator +(const Duration &other) const
+    {
+        return Duration(mValue + other.mValue);
+    }
+
+
+    inline constexpr Duration operator -(const Duration &other) const
+    {
+        return Duration(mValue - other.mValue);
+    }
+
+
+    inline constexpr Duration operator *(unsigned long factor) const
+    {
+        return Duration(mValue * factor);
+    }
+
+
+    /* Whole multiples of other in this */
+    inline constexpr unsigned long operator /(const Duration &other) const
+    {
+        return mValue / other.mValue;
+    }
+
+
+    inline constexpr bool operator <(const Duration &other) const
+    {
+        return mValue < other.mValue;
+    }
+
+
+    inline constexpr bool operator >(const Duration &other) const
+    {
+        return mValue > other.mValue;
+    }
+
+
+    inline constexpr bool operator <=(const Duration &other) const
+    {
+        return mValue <= other.mValue;
+    }
+
+
+    inline constexpr bool operator >=(const Duration &other) const
+    {
+        return mValue >= other.mValue;
+    }
+
+
+    inline constexpr bool operator ==(const Duration &other) const
+    {
+        return mValue == other.mValue;
+    }
+
+};
+
+
+template<typename Clock>
+class Timestamp : public SafeCounter<unsigned long>
+{
+
+public:
+
+    inline constexpr explicit Timestamp(unsigned long value = 0)
+        : SafeCounter<unsigned long>(value)
+    {
+
+    }
+
+
+    inline static Timestamp now()
+    {
+        return Timestamp(Clock::now());
+    }
+
+
+    inline constexpr Duration<Clock> operator -(const Timestamp &earlier) const
+    {
+        return Duration<Clock>(since(earlier));
+    }
+
+
+    inline constexpr Timestamp operator +(const Duration<Clock> &duration) const
+    {
+        return Timestamp(value() + duration.count());
+    }
+
+
+    inline constexpr Timestamp operator -(const Duration<Clock> &duration) const
+    {
+        return Timestamp(value() - duration.count());
+    }
+
+
+    inline Timestamp &operator +=(const Duration<Clock> &duration)
+    {
+        setValue(value() + duration.count());
+
+        return *this;
+    }
+
+
+    inline Duration<Clock> elapsed() const
+    {
+        return now() - *this;
+    }
+
+
+    /* Whether this, as a deadline, has passed */
+    inline bool reached() const
+    {
+        return reachedAt(now());
+    }
+
+};
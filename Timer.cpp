@@ -2,6 +2,7 @@
 #include "Arduino.h"
 
 #include "Application.hpp"
+#include "Trace.hpp"
 
 #include "Timer.hpp"
 
@@ -11,27 +12,76 @@ void Timer::onLoop()
 
     /* TODO: Implement a BST based algorithm */
 
-    if (mStartTime != -1) {
-        unsigned long time = millis();
+    if (!mRunning) {
+        return;
+    }
+
+    SafeCounter<unsigned long> time(this->time());
+    SafeCounter<unsigned long> deadline = mStartTime + mTimeout;
+
+    if (!deadline.reachedAt(time)) {
+        return;
+    }
+
+    SafeCounter<unsigned long> startTime = mStartTime;
+    unsigned long late = time.since(deadline);
+    unsigned long periods = mTimeout == 0 || singleShot() ?
+        0 : late / mTimeout;
+
+    mLateness = late;
+    mMeanLateness8 += late - (mMeanLateness8 >> 3);
+
+    if (late > mWorstLateness) {
+        mWorstLateness = late;
+    }
+
+    mCoalesced = mPolicy == Coalesce ?
+        (periods < 255 ? periods + 1 : 255) : 1;
 
-        if (mStartTime > time) {
-            if ((unsigned long) -1 - mStartTime + time >= timeout()) {
-                expired()->emit();
+    Trace::record(Trace::TimerFire, (uintptr_t) this);
+    expired()->emit();
 
-                mStartTime = singleShot() || mStartTime == -1 ? -1 : millis();
-            }
-        } else if (time - mStartTime >= timeout()) {
-            expired()->emit();
+    if (!mRunning || mStartTime != startTime) {
 
-            mStartTime = singleShot() || mStartTime == -1 ? -1 : millis();
-        }
+        /* Stopped or restarted by a slot */
+
+        return;
+    }
+
+    if (singleShot()) {
+        mRunning = false;
+
+        return;
+    }
+
+    switch (mPolicy) {
+    case Coalesce:
+        mMissed += periods;
+        mStartTime += mTimeout * (periods + 1);
+        break;
+
+    case Burst:
+        mStartTime += mTimeout;
+        break;
+
+    case Skip:
+        mMissed += periods;
+        mStartTime = periods == 0 ? mStartTime + mTimeout : time;
+        break;
     }
 }
 
 
-Timer::Timer(unsigned long timeout, bool singleShot)
+Timer::Timer(unsigned long timeout, bool singleShot, Resolution resolution)
     : EventObject(),
-    mStartTime(-1)
+    mRunning(false),
+    mResolution(resolution),
+    mPolicy(Coalesce),
+    mCoalesced(1),
+    mLateness(0),
+    mWorstLateness(0),
+    mMeanLateness8(0),
+    mMissed(0)
 {
     setTimeout(timeout);
     setSingleShot(singleShot);
@@ -39,3 +89,4 @@ Timer::Timer(unsigned long timeout, bool singleShot)
     /* TODO: disconnect from loop when possible */
     EventObjectConnect(Application::instance(), loop, this, onLoop);
 }
+
@@ -1,12 +1,21 @@
-
 #pragma once
 
 
 #include "Arduino.h"
 
 #include "EventObject.hpp"
-
-
+#include "SafeCounter.hpp"
+
+
+/*
+ * Polled from Application::loop, so expired is emitted as late as the
+ * loop makes it. A periodic timer nonetheless keeps to its grid: the
+ * next deadline is the previous deadline plus the period, not the time
+ * the slots returned, and the Policy says what happens to the deadlines
+ * the loop missed altogether. The lateness of every expiry is kept as
+ * the achieved jitter. Microseconds timers count micros() instead of millis(),
+ * for periods that must not be rounded up to the next millisecond.
+ */
 class Timer : public EventObject
 {
 
@@ -14,25 +23,69 @@ class Timer : public EventObject
     EVENT_OBJECT_SLOT(Timer, onLoop);
 
 
+public:
+
+    enum Resolution
+    {
+        Milliseconds,
+        Microseconds
+    };
+
+
+    enum Policy
+    {
+
+        /* Emit once for all missed periods, see coalesced() */
+        Coalesce,
+
+        /* Emit every missed period, one per pass of the loop */
+        Burst,
+
+        /* Drop the missed periods and restart the grid from now */
+        Skip
+
+    };
+
+
+private:
+
     unsigned long mTimeout;
-    unsigned long mStartTime;
+    SafeCounter<unsigned long> mStartTime;
+    bool mRunning;
     bool mSingleShot;
+    unsigned char mResolution;
+    unsigned char mPolicy;
+    unsigned char mCoalesced;
+
+    unsigned long mLateness;
+    unsigned long mWorstLateness;
+    unsigned long mMeanLateness8;
+    unsigned long mMissed;
 
 
 public:
 
-    explicit Timer(unsigned long timeout = 0, bool singleShot = false);
+    explicit Timer(unsigned long timeout = 0, bool singleShot = false,
+            Resolution resolution = Milliseconds);
+
+
+    /* Current time in the units of this timer */
+    inline unsigned long time() const
+    {
+        return mResolution == Microseconds ? micros() : millis();
+    }
 
 
     inline void start()
     {
-        mStartTime = millis();
+        mStartTime.setValue(time());
+        mRunning = true;
     }
 
 
     inline void stop()
     {
-        mStartTime = -1;
+        mRunning = false;
     }
 
 
@@ -60,15 +113,85 @@ public:
     }
 
 
+    inline Resolution resolution() const
+    {
+        return (Resolution) mResolution;
+    }
+
+
+    /* Takes effect at the next start() */
+    inline void setResolution(Resolution value)
+    {
+        mResolution = value;
+    }
+
+
+    inline Policy policy() const
+    {
+        return (Policy) mPolicy;
+    }
+
+
+    inline void setPolicy(Policy value)
+    {
+        mPolicy = value;
+    }
+
+
+    /*
+     * Periods the current expiry stands for: 1 unless a Coalesce timer
+     * missed deadlines, saturating at 255
+     */
+    inline unsigned char coalesced() const
+    {
+        return mCoalesced;
+    }
+
+
+    /* Deadlines dropped by Coalesce and Skip since construction */
+    inline unsigned long missed() const
+    {
+        return mMissed;
+    }
+
+
+    /* Time from the deadline to the last expiry, in timer units */
+    inline unsigned long lateness() const
+    {
+        return mLateness;
+    }
+
+
+    inline unsigned long worstLateness() const
+    {
+        return mWorstLateness;
+    }
+
+
+    /* Moving average of lateness() over about the last 8 expiries */
+    inline unsigned long meanLateness() const
+    {
+        return mMeanLateness8 >> 3;
+    }
+
+
+    inline void resetJitter()
+    {
+        mLateness = 0;
+        mWorstLateness = 0;
+        mMeanLateness8 = 0;
+    }
+
+
     inline unsigned long startTime() const
     {
-        return mStartTime;
+        return mStartTime.value();
     }
 
 
     inline bool running() const
     {
-        return mStartTime != -1;
+        return mRunning;
     }
 
 
@@ -0,0 +1,68 @@
+#include "Arduino.h"
+
+#include "Trace.hpp"
+
+
+Trace::Record Trace::sRecords[TRACE_CAPACITY];
+uint8_t Trace::sNext = 0;
+bool Trace::sWrapped = false;
+bool Trace::sFrozen = false;
+
+
+void Trace::record(uint8_t kind, uintptr_t address)
+{
+    if (sFrozen) {
+        return;
+    }
+
+    Record &record = sRecords[sNext];
+
+    record.time = micros();
+    record.id = address;
+    record.kind = kind;
+
+    if (++sNext == TRACE_CAPACITY) {
+        sNext = 0;
+        sWrapped = true;
+    }
+}
+
+
+/*
+ * One record per line as "<kind> <id> <time>", kind being one of "EBXPT"
+ * in Kind order and id in hex, between a "trace <count> <now>" header and
+ * a "trace end" trailer.
+ */
+void Trace::dump(Print &out)
+{
+    static const char kinds[] = "EBXPT";
+
+    bool frozen = sFrozen;
+    uint8_t count = sWrapped ? TRACE_CAPACITY : sNext;
+    uint8_t index = sWrapped ? sNext : 0;
+
+    sFrozen = true;
+
+    out.print("trace ");
+    out.print((unsigned int) count);
+    out.print(' ');
+    out.println(micros());
+
+    for (uint8_t i = 0; i < count; i++) {
+        const Record &record = sRecords[index];
+
+        out.print(kinds[record.kind]);
+        out.print(' ');
+        out.print((unsigned int) record.id, HEX);
+        out.print(' ');
+        out.println((unsigned long) record.time);
+
+        if (++index == TRACE_CAPACITY) {
+            index = 0;
+        }
+    }
+
+    out.println("trace end");
+
+    sFrozen = frozen;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+
+#include <stdint.h>
+
+
+#ifndef TRACE_CAPACITY
+#    define TRACE_CAPACITY 64
+#endif
+
+#if TRACE_CAPACITY > 255
+#    error "TRACE_CAPACITY must fit the uint8_t ring index"
+#endif
+
+
+class Print;
+
+
+/*
+ * Always-on ring buffer of the last TRACE_CAPACITY dispatch events. A
+ * record is a kind, the low 16 bits of the emitter, timer or slot address
+ * (the whole address on AVR) and a micros() timestamp, 7 bytes on AVR.
+ * dump() prints the records oldest first; host/trace2json turns the dump
+ * into the Chrome trace format. Debug::panic() freezes and dumps it.
+ */
+class Trace
+{
+
+public:
+
+    enum Kind
+    {
+        Emit,
+        SlotEnter,
+        SlotExit,
+        Post,
+        TimerFire
+    };
+
+
+    struct Record
+    {
+        uint32_t time;
+        uint16_t id;
+        uint8_t kind;
+    };
+
+
+private:
+
+    static Record sRecords[TRACE_CAPACITY];
+    static uint8_t sNext;
+    static bool sWrapped;
+    static bool sFrozen;
+
+
+public:
+
+    static void record(uint8_t kind, uintptr_t address);
+    static void dump(Print &out);
+
+
+    /* Stop recording so that a later dump() shows what led up to now */
+    inline static void freeze()
+    {
+        sFrozen = true;
+    }
+
+
+    inline static void thaw()
+    {
+        sFrozen = false;
+    }
+
+
+};
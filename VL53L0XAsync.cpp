@@ -6,6 +6,7 @@
 #include <Wire.h>
 
 #include "Debug.hpp"
+#include "I2CBus.hpp"
 #include "Application.hpp"
 
 #include "VL53L0XAsync.hpp"
@@ -32,35 +33,33 @@
 #define calcMacroPeriod(vcsel_period_pclks) ((((uint32_t)2304 * (vcsel_period_pclks) * 1655) + 500) / 1000)
 
 
-#define startTimer(slot)                                  \
-    debugAssert(!mTimer.running());                       \
-    EventObjectConnect(&mTimer, expired, this, slot);     \
-    mTimer.setTimeout(10);                                \
-    mTimer.start();                                       \
-                                                          \
-    mExpires = 0;                                         
-
-
-#define stopTimer(slot)                                   \
-    EventObjectDisconnect(&mTimer, expired, this, slot);  \
-    mTimer.stop();                                        \
-
-
 const unsigned char VL53L0XAsync::DefaultAddress = 0b0101001;
+const unsigned char VL53L0XAsync::AddressCheckInterval = 32;
+const unsigned int VL53L0XAsync::PollPeriod = 5000;
+const unsigned char VL53L0XAsync::BootTime = 2;
+const unsigned int VL53L0XAsync::RetryPeriod = 500;
+const unsigned char VL53L0XAsync::RetryDivisor = 32;
+const unsigned char VL53L0XAsync::MaxRetries = 8;
+const unsigned int VL53L0XAsync::IdlePeriod = 200;
 
 
-bool VL53L0XAsync::sDrivingXshut = false;
+// HighSpeed keeps the limits the robot was tuned with. LongRange lowers the
+// signal limit and lengthens the VCSEL pulses as ST's long range example
+// does, at the cost of a phase calibration the first time it is applied.
+const VL53L0XAsync::ProfileConfig VL53L0XAsync::Profiles[ProfilesCount] = {
+    { 0.25, 20000, 700, 40, 14, 10 },
+    { 0.25, 200000, 1200, 20, 14, 10 },
+    { 0.1, 33000, 2000, 80, 18, 14 }
+};
 
 
-bool VL53L0XAsync::tickTimer()
-{
-    return io_timeout > 0 && ++mExpires >= io_timeout / mTimer.timeout();
-}
+bool VL53L0XAsync::sDrivingXshut = false;
 
 
 void VL53L0XAsync::shutdown()
 {
     did_timeout = true;
+    mStarted = false;
 
     if (mXshutPin != 0) {
         pinMode(mXshutPin, OUTPUT);
@@ -69,89 +68,540 @@ void VL53L0XAsync::shutdown()
 }
 
 
-void VL53L0XAsync::start()
+// Map the device range status (RESULT_RANGE_STATUS bits 6:3) the way
+// VL53L0X_get_pal_range_status() does, minus the host side sigma and
+// signal checks
+unsigned char VL53L0XAsync::decodeRangeStatus(uint8_t deviceStatus)
 {
-    debugAssert((initFinished()->emitting() || 
-                initFinished()->lastEmitted() != -1) &&
-            !did_timeout);
+    switch (deviceStatus) {
+    case 11:
+        return RangeValid;
+
+    case 1:
+    case 2:
+    case 3:
+        return RangeHardwareFail;
+
+    case 4:
+        return RangeSignalFail;
+
+    case 6:
+    case 9:
+        return RangePhaseFail;
+
+    case 8:
+    case 10:
+        return RangeMinRangeFail;
+
+    default:
+        return RangeNone;
+    }
+}
+
+
+// Clock a hung bus free and check that the sensor still answers at its
+// own address. One that reset meanwhile answers at DefaultAddress with its
+// calibration still held here, and a warm init moves it back. Only if it
+// answers at neither is the sensor shut down and reinitialised; the rest
+// of the bus keeps ranging either way.
+bool VL53L0XAsync::recoverBus()
+{
+    I2CBus::recover();
+
+    bool answered = readReg(I2C_SLAVE_DEVICE_ADDRESS) == address;
+
+    if (!mBusStats.takeFailure() && answered) {
+        return true;
+    }
+
+    if (address == DefaultAddress || !mCalibrated) {
+        return false;
+    }
 
-    startContinuous();
+    uint8_t ownAddress = address;
+
+    address = DefaultAddress;
+
+    bool reset = readReg(I2C_SLAVE_DEVICE_ADDRESS) == DefaultAddress;
+
+    reset = !mBusStats.takeFailure() && reset;
+
+    address = ownAddress;
+
+    if (reset) {
+        startInit();
+    }
+
+    return reset;
+}
+
+
+void VL53L0XAsync::start()
+{
+    debugAssert((initFinished()->emitting() ||
+                initFinished()->hasEmitted()) && !did_timeout);
     debugAssert(!mTimer.running());
-    EventObjectConnect(&mTimer, expired, this, onRangeReadyTimerExpired);
-    mTimer.setTimeout(measurement_timing_budget_us / 1000 + 1);
+
+    mStarted = true;
+    applyPower();
+}
+
+
+// Bring the sensor to mPower from wherever it is. Before start() there is
+// nothing to do: the owner starts the sensor once its init finishes and
+// that applies the level. A warm init after PowerOff ends the same way.
+void VL53L0XAsync::applyPower()
+{
+    if (!mStarted) {
+        return;
+    }
+
+    if (mPoweredDown) {
+        if (mPower != PowerOff) {
+            mPoweredDown = false;
+            startInit();
+        }
+
+        return;
+    }
+
+    if (!mRanging && mTimer.running()) {
+        return;
+    }
+
+    if (mRanging) {
+        stopRanging();
+    }
+
+    if (mPower == PowerOff) {
+        powerDown();
+
+        return;
+    }
+
+    if (mProfile != mAppliedProfile && configure()) {
+        mConfiguring = true;
+        mTask.restart();
+        mTimer.setTimeout(PollPeriod);
+        mTimer.start();
+
+        return;
+    }
+
+    if (mPower >= PowerIdle) {
+        startRanging();
+    }
+}
+
+
+void VL53L0XAsync::startRanging()
+{
+    startContinuous(mPower == PowerIdle ? IdlePeriod : 0);
+    mSamples = 0;
+    mBusStats.takeFailure();
+    mRanging = true;
+    mRetries = 0;
+    mTimer.setTimeout(samplePeriod());
     mTimer.start();
 }
 
 
-uint16_t VL53L0XAsync::range() const
+// Leave the sensor in software standby with its configuration intact
+void VL53L0XAsync::stopRanging()
+{
+    mTimer.stop();
+    mRanging = false;
+    stopContinuous();
+    writeReg(SYSTEM_INTERRUPT_CLEAR, 0x01);
+}
+
+
+// Hold the sensor in hardware standby. Unlike shutdown() this is not a
+// failure: the owner keeps it started and applyPower() re-inits it warm.
+void VL53L0XAsync::powerDown()
+{
+    mPoweredDown = true;
+    pinMode(mXshutPin, OUTPUT);
+    digitalWrite(mXshutPin, LOW);
+}
+
+
+// A timed measurement never comes quicker than its budget
+unsigned long VL53L0XAsync::samplePeriod() const
+{
+    return mPower == PowerIdle && IdlePeriod * 1000UL >
+        measurement_timing_budget_us ? IdlePeriod * 1000UL :
+        measurement_timing_budget_us;
+}
+
+
+unsigned long VL53L0XAsync::retryPeriod() const
+{
+    unsigned long period = samplePeriod() / RetryDivisor;
+
+    return period > RetryPeriod ? period : RetryPeriod;
+}
+
+
+void VL53L0XAsync::setPower(unsigned char value)
+{
+    if (value == PowerOff && mXshutPin == 0) {
+        value = PowerStandby;
+    }
+
+    if (value == mPower) {
+        return;
+    }
+
+    mPower = value;
+    applyPower();
+}
+
+
+unsigned char VL53L0XAsync::power() const
+{
+    return mPower;
+}
+
+
+void VL53L0XAsync::setProfile(unsigned char value)
 {
-    return mRange > maximum() ? -1 : mRange;
+    debugAssert(value < ProfilesCount);
+
+    if (value == mProfile) {
+        return;
+    }
+
+    mProfile = value;
+    applyPower();
+}
+
+
+// Apply mProfile to a stopped sensor. Return whether its VCSEL periods
+// changed to ones without a known phase calibration, which calibrateTask()
+// then measures.
+bool VL53L0XAsync::configure()
+{
+    const ProfileConfig &profile = Profiles[mProfile];
+    bool periodsChanged =
+        getVcselPulsePeriod(VcselPeriodPreRange) != profile.preRangePeriod ||
+        getVcselPulsePeriod(VcselPeriodFinalRange) != profile.finalRangePeriod;
+
+    mAppliedProfile = mProfile;
+
+    setSignalRateLimit(profile.signalRateLimit);
+
+    if (periodsChanged) {
+        setVcselPulsePeriod(VcselPeriodPreRange, profile.preRangePeriod);
+        setVcselPulsePeriod(VcselPeriodFinalRange, profile.finalRangePeriod);
+    }
+
+    setMeasurementTimingBudget(profile.timingBudget);
+
+    if (!periodsChanged) {
+        return false;
+    }
+
+    if (mPhaseCalibrated & 1 << mProfile) {
+        writeRefCalibration(mCalibration.vhvSettings, mPhaseCal[mProfile]);
+
+        return false;
+    }
+
+    return true;
+}
+
+
+// "Perform the phase calibration. This is needed after changing on vcsel
+// period." The result is kept for the next switch to the same profile.
+bool VL53L0XAsync::calibrateTask()
+{
+    uint8_t vhv_settings;
+
+    PT_BEGIN(&mTask);
+
+    writeReg(SYSTEM_SEQUENCE_CONFIG, 0x02);
+    performSingleRefCalibration(0x00);
+
+    PT_WAIT_UNTIL_OR_TIMEOUT(&mTask, singleRefCalibrationDone(), io_timeout);
+
+    if (mTask.expired()) {
+        shutdown();
+        rangeError()->post();
+        PT_EXIT(&mTask);
+    }
+
+    finishSingleRefCalibration();
+    writeReg(SYSTEM_SEQUENCE_CONFIG, 0xE8);
+
+    readRefCalibration(&vhv_settings, &mPhaseCal[mAppliedProfile]);
+    mPhaseCalibrated |= 1 << mAppliedProfile;
+
+    PT_END(&mTask);
+}
+
+
+// Seed the phase calibration of every profile that runs on the periods the
+// cold init calibrated with
+void VL53L0XAsync::resetPhaseCache()
+{
+    uint8_t preRangePeriod = getVcselPulsePeriod(VcselPeriodPreRange);
+    uint8_t finalRangePeriod = getVcselPulsePeriod(VcselPeriodFinalRange);
+
+    mPhaseCalibrated = 0;
+
+    for (unsigned char i = 0; i < ProfilesCount; i++) {
+        if (Profiles[i].preRangePeriod == preRangePeriod &&
+                Profiles[i].finalRangePeriod == finalRangePeriod) {
+            mPhaseCal[i] = mCalibration.phaseCal;
+            mPhaseCalibrated |= 1 << i;
+        }
+    }
 }
 
 
 uint16_t VL53L0XAsync::delta() const
 {
-    return 40;
+    return Profiles[mProfile].delta;
 }
 
 
 uint16_t VL53L0XAsync::maximum() const
 {
-    return 700;
+    return Profiles[mProfile].maximum;
+}
+
+
+uint16_t VL53L0XAsync::signalRate() const
+{
+    return mSignalRate;
+}
+
+
+uint16_t VL53L0XAsync::ambientRate() const
+{
+    return mAmbientRate;
 }
 
 
+// Recover from a failure. The saved calibration is not trusted any more,
+// so this is always a cold init.
 void VL53L0XAsync::reinit()
 {
     did_timeout = false;
-    startTimer(onStarted);
+    mPoweredDown = false;
+    mCalibrated = false;
+    startInit();
 }
 
 
-void VL53L0XAsync::onRangeReadyTimerExpired()
+void VL53L0XAsync::startInit()
 {
-    if ((readReg(RESULT_INTERRUPT_STATUS) & 0x07) == 0 ||
-            readReg(I2C_SLAVE_DEVICE_ADDRESS) != address) {
+    mRanging = false;
+    mConfiguring = false;
+    mAppliedProfile = NoProfile;
+    mTask.restart();
+    mTimer.setTimeout(PollPeriod);
+    mTimer.start();
+}
+
 
-        EventObjectDisconnect(&mTimer, expired, this,
-                onRangeReadyTimerExpired);
+void VL53L0XAsync::onTimerExpired()
+{
+    if (mRanging) {
+        pollRange();
+    } else if (mConfiguring) {
+        if (calibrateTask()) {
+            mTimer.stop();
+            mConfiguring = false;
+            applyPower();
+        }
+    } else if (initTask()) {
         mTimer.stop();
-        shutdown();
+    }
+}
 
-        rangeError()->post();
 
-        return;
+void VL53L0XAsync::initFail()
+{
+    shutdown();
+    initFailed()->post();
+}
+
+
+// Initialize sensor using sequence based on VL53L0X_DataInit(),
+// VL53L0X_StaticInit(), and VL53L0X_PerformRefCalibration().
+// This function does not perform reference SPAD calibration
+// (VL53L0X_PerformRefSpadManagement()), since the API user manual says that it
+// is performed by ST on the bare modules; it seems like that should work well
+// enough unless a cover glass is added.
+//
+// A warm init, after PowerOff, reuses the SPAD info and the VHV and phase
+// calibration read back at the end of the last cold init. That skips the
+// NVM wait and both reference measurements; the tuning settings are lost
+// with XSHUT and still have to be written.
+bool VL53L0XAsync::initTask()
+{
+    PT_BEGIN(&mTask);
+
+    if (mXshutPin != 0) {
+
+        /* Only one sensor may sit at the default address at a time */
+
+        PT_WAIT_UNTIL(&mTask, !sDrivingXshut);
+        sDrivingXshut = true;
+
+        pinMode(mXshutPin, INPUT);
+        PT_SLEEP(&mTask, BootTime);
+
+        sDrivingXshut = false;
     }
 
-    mRange = readReg16Bit(RESULT_RANGE_STATUS + 10);
+    dataInit();
 
-    writeReg(SYSTEM_INTERRUPT_CLEAR, 0x01);
+    if (!mCalibrated) {
+        getSpadInfo();
+
+        PT_WAIT_UNTIL_OR_TIMEOUT(&mTask, readReg(0x83) != 0, io_timeout);
+
+        if (mTask.expired()) {
+            initFail();
+            PT_EXIT(&mTask);
+        }
+
+        finishSpadInfo();
+    }
+
+    staticInit();
+
+    if (mCalibrated) {
+        writeRefCalibration(mCalibration.vhvSettings, mCalibration.phaseCal);
+    } else {
+
+      // VL53L0X_PerformRefCalibration() begin (VL53L0X_perform_ref_calibration())
+
+      // -- VL53L0X_perform_vhv_calibration() begin
+
+        writeReg(SYSTEM_SEQUENCE_CONFIG, 0x01);
+        performSingleRefCalibration(0x40);
+
+        PT_WAIT_UNTIL_OR_TIMEOUT(&mTask, singleRefCalibrationDone(),
+                io_timeout);
+
+        if (mTask.expired()) {
+            initFail();
+            PT_EXIT(&mTask);
+        }
+
+        finishSingleRefCalibration();
 
-    rangeReady()->post();
+      // -- VL53L0X_perform_vhv_calibration() end
+
+      // -- VL53L0X_perform_phase_calibration() begin
+
+        writeReg(SYSTEM_SEQUENCE_CONFIG, 0x02);
+        performSingleRefCalibration(0x00);
+
+        PT_WAIT_UNTIL_OR_TIMEOUT(&mTask, singleRefCalibrationDone(),
+                io_timeout);
+
+        if (mTask.expired()) {
+            initFail();
+            PT_EXIT(&mTask);
+        }
+
+        finishSingleRefCalibration();
+
+      // -- VL53L0X_perform_phase_calibration() end
+
+        readRefCalibration(&mCalibration.vhvSettings, &mCalibration.phaseCal);
+        resetPhaseCache();
+        mCalibrated = true;
+    }
+
+  // "restore the previous Sequence Config"
+  writeReg(SYSTEM_SEQUENCE_CONFIG, 0xE8);
+
+  // VL53L0X_PerformRefCalibration() end
+
+    initFinished()->post();
+
+    PT_END(&mTask);
 }
 
 
-void VL53L0XAsync::onSpadInfoTimerExpired()
+void VL53L0XAsync::pollRange()
 {
-    if (readReg(0x83) == 0) {
-        if (tickTimer()) {
-            stopTimer(onSpadInfoTimerExpired);
-            shutdown();
-            initFailed()->post();
+    /*
+     * RESULT_INTERRUPT_STATUS immediately precedes the 12 byte
+     * RESULT_RANGE_STATUS block, so a single burst fetches both. The
+     * address sanity check costs a transaction of its own and only runs
+     * once every AddressCheckInterval samples.
+     */
+
+    uint8_t result[13];
+    const uint8_t *block = result + 1;
+
+    readMulti(RESULT_INTERRUPT_STATUS, result, sizeof(result));
+
+    if (mBusStats.takeFailure()) {
+        if (recoverBus()) {
+
+            /* Still ranging, or warm starting after a reset; drop the sample */
+
+            return;
         }
+    } else if ((result[0] & 0x07) == 0) {
+
+        /* Polled ahead of the sensor clock; look again shortly */
+
+        if (++mRetries <= MaxRetries) {
+            mTimer.setTimeout(retryPeriod());
+
+            return;
+        }
+    } else if (++mSamples % AddressCheckInterval != 0 ||
+            readReg(I2C_SLAVE_DEVICE_ADDRESS) == address) {
+
+        mSignalRate = (uint16_t) block[6] << 8 | block[7];
+        mAmbientRate = (uint16_t) block[8] << 8 | block[9];
+
+        writeReg(SYSTEM_INTERRUPT_CLEAR, 0x01);
+
+        mRetries = 0;
+        mTimer.setTimeout(samplePeriod());
+
+        /*
+         * Last, as the obstacleChanged it may emit can reach setProfile()
+         * or setPower() on this very sensor
+         */
+
+        writeSample((uint16_t) block[10] << 8 | block[11],
+                decodeRangeStatus((block[0] >> 3) & 0x0F));
+
+        rangeReady()->post();
 
         return;
     }
 
-    stopTimer(onSpadInfoTimerExpired);
+    mTimer.stop();
+    mRanging = false;
+    shutdown();
+
+    rangeError()->post();
+}
+
 
+// Finish VL53L0X_get_info_from_device() once getSpadInfo() reports ready
+void VL53L0XAsync::finishSpadInfo()
+{
   uint8_t tmp;
 
   writeReg(0x83, 0x01);
   tmp = readReg(0x92);
 
-  uint8_t spad_count = tmp & 0x7f;
-  bool spad_type_is_aperture = (tmp >> 7) & 0x01;
+  mCalibration.spadCount = tmp & 0x7f;
+  mCalibration.spadTypeIsAperture = (tmp >> 7) & 0x01;
 
   writeReg(0x81, 0x00);
   writeReg(0xFF, 0x06);
@@ -161,6 +611,14 @@ void VL53L0XAsync::onSpadInfoTimerExpired()
 
   writeReg(0xFF, 0x00);
   writeReg(0x80, 0x00);
+}
+
+
+// VL53L0X_StaticInit(), with the SPAD info from finishSpadInfo()
+void VL53L0XAsync::staticInit()
+{
+  uint8_t spad_count = mCalibration.spadCount;
+  bool spad_type_is_aperture = mCalibration.spadTypeIsAperture;
 
   // VL53L0X_StaticInit() begin
 
@@ -322,58 +780,37 @@ void VL53L0XAsync::onSpadInfoTimerExpired()
   setMeasurementTimingBudget(measurement_timing_budget_us);
 
   // VL53L0X_StaticInit() end
-
-  // VL53L0X_PerformRefCalibration() begin (VL53L0X_perform_ref_calibration())
-
-  // -- VL53L0X_perform_vhv_calibration() begin
-
-    singleRefCalibration()->disconnect(this, nullptr);
-    EventObjectOnce(this, singleRefCalibration, this, onVhvCalibration);
-
-    writeReg(SYSTEM_SEQUENCE_CONFIG, 0x01);
-    performSingleRefCalibration(0x40);
-
-  // -- VL53L0X_perform_vhv_calibration() end
-}
-
-
-void VL53L0XAsync::onVhvCalibration()
-{
-    singleRefCalibration()->disconnect(this, nullptr);
-    EventObjectOnce(this, singleRefCalibration, this, onPhaseCalibration);
-    
-  // -- VL53L0X_perform_phase_calibration() begin
-
-  writeReg(SYSTEM_SEQUENCE_CONFIG, 0x02);
-  performSingleRefCalibration(0x00);
-
-  // -- VL53L0X_perform_phase_calibration() end
-}
-
-
-void VL53L0XAsync::onPhaseCalibration()
-{
-  // "restore the previous Sequence Config"
-  writeReg(SYSTEM_SEQUENCE_CONFIG, 0xE8);
-
-  // VL53L0X_PerformRefCalibration() end
-
-    initFinished()->post();
-
 }
 
 
 // Constructors ////////////////////////////////////////////////////////////////
 
 VL53L0XAsync::VL53L0XAsync(unsigned char xshutPin, unsigned char address)
-  : address(address)
-  , io_timeout(100) // no timeout
-  , did_timeout(false),
-    mTimer(10),
-    mRange(0),
-    mXshutPin(xshutPin)
+    : RangeSensor(),
+    mXshutPin(xshutPin),
+    mSamples(0),
+    mRetries(0),
+    mPower(PowerActive),
+    mProfile(HighSpeed),
+    mAppliedProfile(NoProfile),
+    mPhaseCalibrated(0),
+    mSignalRate(0),
+    mAmbientRate(0),
+    mTimer(PollPeriod, false, Timer::Microseconds),
+    mRanging(false),
+    mConfiguring(false),
+    mStarted(false),
+    mPoweredDown(false),
+    mCalibrated(false),
+    address(address),
+    io_timeout(100),
+    did_timeout(false)
 {
     EventObjectConnect(Application::instance(), started, this, onStarted);
+    EventObjectConnect(&mTimer, expired, this, onTimerExpired);
+
+    /* The sensor keeps its own clock; a late poll starts a new phase */
+    mTimer.setPolicy(Timer::Skip);
 
     if (xshutPin != 0) {
         pinMode(xshutPin, OUTPUT);
@@ -384,43 +821,16 @@ VL53L0XAsync::VL53L0XAsync(unsigned char xshutPin, unsigned char address)
 // Public Methods //////////////////////////////////////////////////////////////
 
 
-// Initialize sensor using sequence based on VL53L0X_DataInit(),
-// VL53L0X_StaticInit(), and VL53L0X_PerformRefCalibration().
-// This function does not perform reference SPAD calibration
-// (VL53L0X_PerformRefSpadManagement()), since the API user manual says that it
-// is performed by ST on the bare modules; it seems like that should work well
-// enough unless a cover glass is added.
-// If io_2v8 (optional) is true or not given, the sensor is configured for 2V8
-// mode.
 void VL53L0XAsync::onStarted()
 {
-    stopTimer(onStarted);
-
-    if (mXshutPin != 0) {
-        if (sDrivingXshut) {
-            startTimer(onStarted);
-
-            return;
-        }
-
-        sDrivingXshut = true;
-
-        pinMode(mXshutPin, INPUT);
-        startTimer(onStartedTimerExpired);
-    } else {
-        onStartedTimerExpired();
-    }
+    startInit();
 }
 
 
-void VL53L0XAsync::onStartedTimerExpired()
+// Move the sensor to its own address and run VL53L0X_DataInit().
+// The sensor is configured for 2V8 I/O mode.
+void VL53L0XAsync::dataInit()
 {
-    if (mTimer.running()) {
-        sDrivingXshut = false;
-    }
-
-    stopTimer(onStartedTimerExpired);
-
     if (address != DefaultAddress) {
         unsigned char tmpAddress = address;
 
@@ -461,8 +871,13 @@ void VL53L0XAsync::onStartedTimerExpired()
   writeReg(SYSTEM_SEQUENCE_CONFIG, 0xFF);
 
   // VL53L0X_DataInit() end
+}
 
-    getSpadInfo();
+// Request count bytes from the sensor, recording a short read
+void VL53L0XAsync::requestFrom(uint8_t count)
+{
+  mBusStats.record(I2CBus::requestStatus(count,
+        Wire.requestFrom(address, count)));
 }
 
 // Write an 8-bit register
@@ -471,8 +886,7 @@ void VL53L0XAsync::writeReg(uint8_t reg, uint8_t value)
   Wire.beginTransmission(address);
   Wire.write(reg);
   Wire.write(value);
-  Wire.endTransmission();
-  //last_status = Wire.endTransmission();
+  mBusStats.record(Wire.endTransmission());
 }
 
 // Write a 16-bit register
@@ -482,8 +896,7 @@ void VL53L0XAsync::writeReg16Bit(uint8_t reg, uint16_t value)
   Wire.write(reg);
   Wire.write((value >> 8) & 0xFF); // value high byte
   Wire.write( value       & 0xFF); // value low byte
-  Wire.endTransmission();
-  //last_status = Wire.endTransmission();
+  mBusStats.record(Wire.endTransmission());
 }
 
 // Write a 32-bit register
@@ -495,8 +908,7 @@ void VL53L0XAsync::writeReg32Bit(uint8_t reg, uint32_t value)
   Wire.write((value >> 16) & 0xFF);
   Wire.write((value >>  8) & 0xFF);
   Wire.write( value        & 0xFF); // value lowest byte
-  Wire.endTransmission();
-  //last_status = Wire.endTransmission();
+  mBusStats.record(Wire.endTransmission());
 }
 
 // Read an 8-bit register
@@ -506,10 +918,9 @@ uint8_t VL53L0XAsync::readReg(uint8_t reg)
 
   Wire.beginTransmission(address);
   Wire.write(reg);
-  Wire.endTransmission();
-  //last_status = Wire.endTransmission();
+  mBusStats.record(Wire.endTransmission());
 
-  Wire.requestFrom(address, (uint8_t)1);
+  requestFrom(1);
   value = Wire.read();
 
   return value;
@@ -522,10 +933,9 @@ uint16_t VL53L0XAsync::readReg16Bit(uint8_t reg)
 
   Wire.beginTransmission(address);
   Wire.write(reg);
-  Wire.endTransmission();
-  //last_status = Wire.endTransmission();
+  mBusStats.record(Wire.endTransmission());
 
-  Wire.requestFrom(address, (uint8_t)2);
+  requestFrom(2);
   value  = (uint16_t)Wire.read() << 8; // value high byte
   value |=           Wire.read();      // value low byte
 
@@ -539,10 +949,9 @@ uint32_t VL53L0XAsync::readReg32Bit(uint8_t reg)
 
   Wire.beginTransmission(address);
   Wire.write(reg);
-  Wire.endTransmission();
-  //last_status = Wire.endTransmission();
+  mBusStats.record(Wire.endTransmission());
 
-  Wire.requestFrom(address, (uint8_t)4);
+  requestFrom(4);
   value  = (uint32_t)Wire.read() << 24; // value highest byte
   value |= (uint32_t)Wire.read() << 16;
   value |= (uint16_t)Wire.read() <<  8;
@@ -563,8 +972,7 @@ void VL53L0XAsync::writeMulti(uint8_t reg, uint8_t const * src, uint8_t count)
     Wire.write(*(src++));
   }
 
-  Wire.endTransmission();
-  //last_status = Wire.endTransmission();
+  mBusStats.record(Wire.endTransmission());
 }
 
 // Read an arbitrary number of bytes from the sensor, starting at the given
@@ -573,10 +981,9 @@ void VL53L0XAsync::readMulti(uint8_t reg, uint8_t * dst, uint8_t count)
 {
   Wire.beginTransmission(address);
   Wire.write(reg);
-  Wire.endTransmission();
-  //last_status = Wire.endTransmission();
+  mBusStats.record(Wire.endTransmission());
 
-  Wire.requestFrom(address, count);
+  requestFrom(count);
 
   while (count-- > 0)
   {
@@ -630,7 +1037,7 @@ bool VL53L0XAsync::setMeasurementTimingBudget(uint32_t budget_us)
   uint32_t const MinTimingBudget = 20000;
 
 
-    if ((!initFinished()->emitting() && initFinished()->lastEmitted() == -1) ||
+    if ((!initFinished()->emitting() && !initFinished()->hasEmitted()) ||
             did_timeout) {
 
         return false;
@@ -757,6 +1164,180 @@ uint32_t VL53L0XAsync::getMeasurementTimingBudget(void)
   return budget_us;
 }
 
+// Set the VCSEL (vertical cavity surface emitting laser) pulse period for the
+// given period type (pre-range or final range) to the given value in PCLKs.
+// Longer periods seem to increase the potential range of the sensor.
+// Valid values are (even numbers only):
+//  pre:  12 to 18 (initialized default: 14)
+//  final: 8 to 14 (initialized default: 10)
+// Unlike VL53L0X_set_vcsel_pulse_period() this leaves out the phase
+// calibration, which has to be waited for; see calibrateTask().
+// based on VL53L0X_set_vcsel_pulse_period()
+bool VL53L0XAsync::setVcselPulsePeriod(vcselPeriodType type, uint8_t period_pclks)
+{
+  uint8_t vcsel_period_reg = encodeVcselPeriod(period_pclks);
+
+  SequenceStepEnables enables;
+  SequenceStepTimeouts timeouts;
+
+  getSequenceStepEnables(&enables);
+  getSequenceStepTimeouts(&enables, &timeouts);
+
+  // "Apply specific settings for the requested clock period"
+  // "Re-calculate and apply timeouts, in macro periods"
+
+  // "When the VCSEL period for the pre or final range is changed,
+  // the corresponding timeout must be read from the device using
+  // the current VCSEL period, then the new VCSEL period can be
+  // applied. The timeout then must be written back to the device
+  // using the new VCSEL period.
+  //
+  // For the MSRC timeout, the same applies - this timeout being
+  // dependant on the pre-range vcsel period."
+
+
+  if (type == VcselPeriodPreRange)
+  {
+    // "Set phase check limits"
+    switch (period_pclks)
+    {
+      case 12:
+        writeReg(PRE_RANGE_CONFIG_VALID_PHASE_HIGH, 0x18);
+        break;
+
+      case 14:
+        writeReg(PRE_RANGE_CONFIG_VALID_PHASE_HIGH, 0x30);
+        break;
+
+      case 16:
+        writeReg(PRE_RANGE_CONFIG_VALID_PHASE_HIGH, 0x40);
+        break;
+
+      case 18:
+        writeReg(PRE_RANGE_CONFIG_VALID_PHASE_HIGH, 0x50);
+        break;
+
+      default:
+        // invalid period
+        return false;
+    }
+    writeReg(PRE_RANGE_CONFIG_VALID_PHASE_LOW, 0x08);
+
+    // apply new VCSEL period
+    writeReg(PRE_RANGE_CONFIG_VCSEL_PERIOD, vcsel_period_reg);
+
+    // update timeouts
+
+    // set_sequence_step_timeout() begin
+    // (SequenceStepId == VL53L0X_SEQUENCESTEP_PRE_RANGE)
+
+    uint16_t new_pre_range_timeout_mclks =
+      timeoutMicrosecondsToMclks(timeouts.pre_range_us, period_pclks);
+
+    writeReg16Bit(PRE_RANGE_CONFIG_TIMEOUT_MACROP_HI,
+      encodeTimeout(new_pre_range_timeout_mclks));
+
+    // set_sequence_step_timeout() end
+
+    // set_sequence_step_timeout() begin
+    // (SequenceStepId == VL53L0X_SEQUENCESTEP_MSRC)
+
+    uint16_t new_msrc_timeout_mclks =
+      timeoutMicrosecondsToMclks(timeouts.msrc_dss_tcc_us, period_pclks);
+
+    writeReg(MSRC_CONFIG_TIMEOUT_MACROP,
+      (new_msrc_timeout_mclks > 256) ? 255 : (new_msrc_timeout_mclks - 1));
+
+    // set_sequence_step_timeout() end
+  }
+  else if (type == VcselPeriodFinalRange)
+  {
+    switch (period_pclks)
+    {
+      case 8:
+        writeReg(FINAL_RANGE_CONFIG_VALID_PHASE_HIGH, 0x10);
+        writeReg(FINAL_RANGE_CONFIG_VALID_PHASE_LOW,  0x08);
+        writeReg(GLOBAL_CONFIG_VCSEL_WIDTH, 0x02);
+        writeReg(ALGO_PHASECAL_CONFIG_TIMEOUT, 0x0C);
+        writeReg(0xFF, 0x01);
+        writeReg(ALGO_PHASECAL_LIM, 0x30);
+        writeReg(0xFF, 0x00);
+        break;
+
+      case 10:
+        writeReg(FINAL_RANGE_CONFIG_VALID_PHASE_HIGH, 0x28);
+        writeReg(FINAL_RANGE_CONFIG_VALID_PHASE_LOW,  0x08);
+        writeReg(GLOBAL_CONFIG_VCSEL_WIDTH, 0x03);
+        writeReg(ALGO_PHASECAL_CONFIG_TIMEOUT, 0x09);
+        writeReg(0xFF, 0x01);
+        writeReg(ALGO_PHASECAL_LIM, 0x20);
+        writeReg(0xFF, 0x00);
+        break;
+
+      case 12:
+        writeReg(FINAL_RANGE_CONFIG_VALID_PHASE_HIGH, 0x38);
+        writeReg(FINAL_RANGE_CONFIG_VALID_PHASE_LOW,  0x08);
+        writeReg(GLOBAL_CONFIG_VCSEL_WIDTH, 0x03);
+        writeReg(ALGO_PHASECAL_CONFIG_TIMEOUT, 0x08);
+        writeReg(0xFF, 0x01);
+        writeReg(ALGO_PHASECAL_LIM, 0x20);
+        writeReg(0xFF, 0x00);
+        break;
+
+      case 14:
+        writeReg(FINAL_RANGE_CONFIG_VALID_PHASE_HIGH, 0x48);
+        writeReg(FINAL_RANGE_CONFIG_VALID_PHASE_LOW,  0x08);
+        writeReg(GLOBAL_CONFIG_VCSEL_WIDTH, 0x03);
+        writeReg(ALGO_PHASECAL_CONFIG_TIMEOUT, 0x07);
+        writeReg(0xFF, 0x01);
+        writeReg(ALGO_PHASECAL_LIM, 0x20);
+        writeReg(0xFF, 0x00);
+        break;
+
+      default:
+        // invalid period
+        return false;
+    }
+
+    // apply new VCSEL period
+    writeReg(FINAL_RANGE_CONFIG_VCSEL_PERIOD, vcsel_period_reg);
+
+    // update timeouts
+
+    // set_sequence_step_timeout() begin
+    // (SequenceStepId == VL53L0X_SEQUENCESTEP_FINAL_RANGE)
+
+    // "For the final range timeout, the pre-range timeout
+    //  must be added. To do this both final and pre-range
+    //  timeouts must be expressed in macro periods MClks
+    //  because they have different vcsel periods."
+
+    uint16_t new_final_range_timeout_mclks =
+      timeoutMicrosecondsToMclks(timeouts.final_range_us, period_pclks);
+
+    if (enables.pre_range)
+    {
+      new_final_range_timeout_mclks += timeouts.pre_range_mclks;
+    }
+
+    writeReg16Bit(FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI,
+      encodeTimeout(new_final_range_timeout_mclks));
+
+    // set_sequence_step_timeout end
+  }
+  else
+  {
+    // invalid type
+    return false;
+  }
+
+  // "Finally, the timing budget must be re-applied"
+
+  setMeasurementTimingBudget(measurement_timing_budget_us);
+
+  return true;
+}
+
 // Get the VCSEL pulse period in PCLKs for the given period type.
 // based on VL53L0X_get_vcsel_pulse_period()
 uint8_t VL53L0XAsync::getVcselPulsePeriod(vcselPeriodType type)
@@ -814,6 +1395,19 @@ void VL53L0XAsync::startContinuous(uint32_t period_ms)
   }
 }
 
+// Stop continuous measurements, leaving the sensor in software standby
+// based on VL53L0X_StopMeasurement()
+void VL53L0XAsync::stopContinuous()
+{
+  writeReg(SYSRANGE_START, 0x01); // VL53L0X_REG_SYSRANGE_MODE_SINGLESHOT
+
+  writeReg(0xFF, 0x01);
+  writeReg(0x00, 0x00);
+  writeReg(0x91, 0x00);
+  writeReg(0x00, 0x01);
+  writeReg(0xFF, 0x00);
+}
+
 // Private Methods /////////////////////////////////////////////////////////////
 
 // Get reference SPAD (single photon avalanche diode) count and type
@@ -834,8 +1428,6 @@ void VL53L0XAsync::getSpadInfo()
 
   writeReg(0x94, 0x6b);
   writeReg(0x83, 0x00);
-
-  startTimer(onSpadInfoTimerExpired);
 }
 
 // Get sequence step enables
@@ -941,33 +1533,62 @@ uint32_t VL53L0XAsync::timeoutMicrosecondsToMclks(uint32_t timeout_period_us, ui
 }
 
 
-// based on VL53L0X_perform_single_ref_calibration()
+// based on VL53L0X_perform_single_ref_calibration(), which is finished by
+// finishSingleRefCalibration() once singleRefCalibrationDone() holds
 void VL53L0XAsync::performSingleRefCalibration(uint8_t vhv_init_byte)
 {
   writeReg(SYSRANGE_START, 0x01 | vhv_init_byte); // VL53L0X_REG_SYSRANGE_MODE_START_STOP
+}
+
+
+// VL53L0X_get_ref_calibration(): VHV settings and phase calibration as
+// left behind by the two single reference calibrations
+// based on VL53L0X_ref_calibration_io()
+void VL53L0XAsync::readRefCalibration(uint8_t * vhv_settings,
+    uint8_t * phase_cal)
+{
+  writeReg(0xFF, 0x01);
+  writeReg(0x00, 0x00);
+  writeReg(0xFF, 0x00);
 
-  startTimer(onPerformSingleRefCalibrationTimerExpired);
+  *vhv_settings = readReg(0xCB);
+  *phase_cal = readReg(0xEE);
+
+  writeReg(0xFF, 0x01);
+  writeReg(0x00, 0x01);
+  writeReg(0xFF, 0x00);
 }
 
 
-void VL53L0XAsync::onPerformSingleRefCalibrationTimerExpired()
+// VL53L0X_set_ref_calibration(); the top bit of the phase register is
+// not part of the calibration and is kept
+// based on VL53L0X_ref_calibration_io()
+void VL53L0XAsync::writeRefCalibration(uint8_t vhv_settings,
+    uint8_t phase_cal)
 {
-    if ((readReg(RESULT_INTERRUPT_STATUS) & 0x07) == 0 ||
-            readReg(I2C_SLAVE_DEVICE_ADDRESS) != address) {
+  writeReg(0xFF, 0x01);
+  writeReg(0x00, 0x00);
+  writeReg(0xFF, 0x00);
 
-        if (tickTimer()) {
-            stopTimer(onPerformSingleRefCalibrationTimerExpired);
-            shutdown();
-            initFailed()->post();
-        }
+  writeReg(0xCB, vhv_settings);
+  writeReg(0xEE, (readReg(0xEE) & 0x80) | (phase_cal & 0x7F));
 
-        return;
-    }
+  writeReg(0xFF, 0x01);
+  writeReg(0x00, 0x01);
+  writeReg(0xFF, 0x00);
+}
 
-    stopTimer(onPerformSingleRefCalibrationTimerExpired);
-    writeReg(SYSTEM_INTERRUPT_CLEAR, 0x01);
 
-    writeReg(SYSRANGE_START, 0x00);
+bool VL53L0XAsync::singleRefCalibrationDone()
+{
+    return (readReg(RESULT_INTERRUPT_STATUS) & 0x07) != 0 &&
+        readReg(I2C_SLAVE_DEVICE_ADDRESS) == address;
+}
+
+
+void VL53L0XAsync::finishSingleRefCalibration()
+{
+  writeReg(SYSTEM_INTERRUPT_CLEAR, 0x01);
 
-    singleRefCalibration()->post();
+  writeReg(SYSRANGE_START, 0x00);
 }
@@ -4,47 +4,159 @@
 
 #include "Arduino.h"
 
+#include "I2CBus.hpp"
+#include "Protothread.hpp"
 #include "RangeSensor.hpp"
 #include "Timer.hpp"
 
 
-class VL53L0XAsync : public RangeSensor
+class VL53L0XAsync final : public RangeSensor
 {
 
-    EVENT_OBJECT_SIGNAL(VL53L0XAsync, singleRefCalibration);
+public:
+
+    /*
+     * Ranging presets after ST's application notes. A profile sets the
+     * signal rate limit, both VCSEL periods and the timing budget, and
+     * with them what maximum() and delta() advertise.
+     */
+    enum Profile
+    {
+        HighSpeed,
+        HighAccuracy,
+        LongRange
+    };
+
+
+    static const unsigned char ProfilesCount = 3;
+
+
+private:
 
-    EVENT_OBJECT_SLOT(VL53L0XAsync, onSpadInfoTimerExpired);
-    EVENT_OBJECT_SLOT(VL53L0XAsync, onPerformSingleRefCalibrationTimerExpired);
-    EVENT_OBJECT_SLOT(VL53L0XAsync, onVhvCalibration);
-    EVENT_OBJECT_SLOT(VL53L0XAsync, onPhaseCalibration);
-    EVENT_OBJECT_SLOT(VL53L0XAsync, onRangeReadyTimerExpired);
+    EVENT_OBJECT_SLOT(VL53L0XAsync, onTimerExpired);
     EVENT_OBJECT_SLOT(VL53L0XAsync, onStarted);
-    EVENT_OBJECT_SLOT(VL53L0XAsync, onStartedTimerExpired);
 
 
     static const unsigned char DefaultAddress;
+    static const unsigned char AddressCheckInterval;
+    /* Microseconds between init polls, ms from XSHUT release to boot */
+    static const unsigned int PollPeriod;
+    static const unsigned char BootTime;
+
+    /*
+     * Polls of a sample that is not ready yet: MaxRetries of them, one
+     * every RetryDivisor-th of the sample period but at least RetryPeriod
+     * microseconds apart, so the sensor clock may trail ours by a quarter
+     * of the period before the sample counts as lost
+     */
+    static const unsigned int RetryPeriod;
+    static const unsigned char RetryDivisor;
+    static const unsigned char MaxRetries;
+
+    /* Milliseconds between timed measurements at PowerIdle */
+    static const unsigned int IdlePeriod;
+
+
+    struct ProfileConfig
+    {
+        float signalRateLimit;      /* MCPS */
+        uint32_t timingBudget;      /* us */
+        uint16_t maximum;           /* mm */
+        uint16_t delta;             /* mm */
+        uint8_t preRangePeriod;     /* VCSEL PCLKs */
+        uint8_t finalRangePeriod;
+    };
+
+
+    static const ProfileConfig Profiles[ProfilesCount];
+
+    /* mAppliedProfile after an init, when the sensor runs its defaults */
+    static const unsigned char NoProfile = 0xFF;
+
+
+    /* Kept from a cold init so that waking from PowerOff can skip it */
+    struct Calibration
+    {
+        uint8_t spadCount;
+        bool spadTypeIsAperture;
+        uint8_t vhvSettings;
+        uint8_t phaseCal;
+    };
 
 
     static bool sDrivingXshut;
 
 
     const unsigned char mXshutPin;
-    unsigned char mExpires;
-    uint16_t mRange;
+    unsigned char mSamples;
+    unsigned char mRetries;
+    unsigned char mPower;
+    unsigned char mProfile;
+    unsigned char mAppliedProfile;
+
+    /* Phase calibration per profile, valid where mPhaseCalibrated is set */
+    uint8_t mPhaseCal[ProfilesCount];
+    unsigned char mPhaseCalibrated;
+
+    uint16_t mSignalRate;
+    uint16_t mAmbientRate;
     Timer mTimer;
-
-
-    bool tickTimer();
+    Protothread mTask;
+    Calibration mCalibration;
+    bool mRanging;
+    bool mConfiguring;
+    bool mStarted;
+    bool mPoweredDown;
+    bool mCalibrated;
+    I2CBus::Stats mBusStats;
+
+
+    void startInit();
+    bool initTask();
+    bool calibrateTask();
+    bool configure();
+    void resetPhaseCache();
+    void initFail();
+    void pollRange();
     void shutdown();
+    void applyPower();
+    void startRanging();
+    void stopRanging();
+    void powerDown();
+    unsigned long samplePeriod() const;
+    unsigned long retryPeriod() const;
+    bool recoverBus();
+    void requestFrom(uint8_t count);
+
+    static unsigned char decodeRangeStatus(uint8_t deviceStatus);
 
 
 public:
 
     virtual void start() override;
     virtual void reinit() override;
-    virtual uint16_t range() const override;
     virtual uint16_t delta() const override;
     virtual uint16_t maximum() const override;
+    virtual uint16_t signalRate() const override;
+    virtual uint16_t ambientRate() const override;
+    virtual void setPower(unsigned char value) override;
+    virtual unsigned char power() const override;
+
+    /* Switch to a Profile, at once or after a phase calibration */
+    void setProfile(unsigned char value);
+
+
+    inline unsigned char profile() const
+    {
+        return mProfile;
+    }
+
+
+
+    inline const I2CBus::Stats &busStats() const
+    {
+        return mBusStats;
+    }
 
 
   public:
@@ -136,8 +248,6 @@ public:
 
     enum vcselPeriodType { VcselPeriodPreRange, VcselPeriodFinalRange };
 
-    //uint8_t last_status; // status of last I2C transmission
-
     VL53L0XAsync(unsigned char xshutPin = 0,
             unsigned char address = DefaultAddress);
 
@@ -159,6 +269,7 @@ public:
     bool setMeasurementTimingBudget(uint32_t budget_us);
     uint32_t getMeasurementTimingBudget(void);
 
+    bool setVcselPulsePeriod(vcselPeriodType type, uint8_t period_pclks);
     uint8_t getVcselPulsePeriod(vcselPeriodType type);
 
     void startContinuous(uint32_t period_ms = 0);
@@ -196,13 +307,20 @@ public:
 
     //bool getSpadInfo(uint8_t * count, bool * type_is_aperture);
 
+    void dataInit();
     void getSpadInfo();
+    void finishSpadInfo();
+    void staticInit();
+    void readRefCalibration(uint8_t * vhv_settings, uint8_t * phase_cal);
+    void writeRefCalibration(uint8_t vhv_settings, uint8_t phase_cal);
 
     void getSequenceStepEnables(SequenceStepEnables * enables);
     void getSequenceStepTimeouts(SequenceStepEnables const * enables, SequenceStepTimeouts * timeouts);
 
     //bool performSingleRefCalibration(uint8_t vhv_init_byte);
     void performSingleRefCalibration(uint8_t vhv_init_byte);
+    bool singleRefCalibrationDone();
+    void finishSingleRefCalibration();
 
     static uint16_t decodeTimeout(uint16_t value);
     static uint16_t encodeTimeout(uint16_t timeout_mclks);
@@ -0,0 +1,156 @@
+#include "Arduino.h"
+
+#ifdef __AVR__
+#    include <avr/wdt.h>
+#endif
+
+#include "Debug.hpp"
+#include "Application.hpp"
+
+#include "Watchdog.hpp"
+
+
+#define WATCHDOG_HANG_MAGIC 0x5AA5
+
+
+/* Survive the watchdog reset: .noinit is left alone by the C runtime */
+static uint16_t hangMagic __attribute__((section(".noinit")));
+static uintptr_t hangSlot __attribute__((section(".noinit")));
+
+
+Watchdog Watchdog::sInstance;
+
+EventEmitter::Slot volatile Watchdog::sSlot = nullptr;
+volatile bool Watchdog::sHung = false;
+unsigned char Watchdog::sTimeout = WDTO_2S;
+
+unsigned long Watchdog::sBudget = 10000;
+unsigned long Watchdog::sOverruns = 0;
+unsigned long Watchdog::sWorstDuration = 0;
+EventEmitter::Slot Watchdog::sWorstSlot = nullptr;
+EventEmitter::Slot Watchdog::sLastOverrunSlot = nullptr;
+uintptr_t Watchdog::sResetSlot = 0;
+
+
+#ifdef __AVR__
+
+
+static uint8_t resetFlags __attribute__((section(".noinit")));
+
+
+/*
+ * A watchdog reset leaves WDE set at the shortest timeout, which would
+ * reset the board again long before setup() reaches begin(). Turn it off
+ * ahead of the static constructors, keeping the reset cause for begin().
+ */
+static void disableEarly() __attribute__((naked, used, section(".init3")));
+
+
+static void disableEarly()
+{
+    resetFlags = MCUSR;
+    MCUSR = 0;
+    wdt_disable();
+}
+
+
+ISR(WDT_vect)
+{
+    Watchdog::onHang();
+}
+
+
+#endif
+
+
+void Watchdog::onLoop()
+{
+    feed();
+}
+
+
+/*
+ * Interrupt and system reset mode: the first timeout runs WDT_vect (which
+ * clears WDIE in hardware), the second one resets the board.
+ */
+void Watchdog::arm()
+{
+#ifdef __AVR__
+    noInterrupts();
+    wdt_reset();
+    WDTCSR = _BV(WDCE) | _BV(WDE);
+    WDTCSR = _BV(WDIE) | _BV(WDE) |
+        (sTimeout & 0x08 ? _BV(WDP3) : 0) | (sTimeout & 0x07);
+    interrupts();
+#endif
+}
+
+
+void Watchdog::begin(unsigned char timeout, unsigned long budget)
+{
+#ifdef __AVR__
+    bool watchdogReset = resetFlags & _BV(WDRF);
+#else
+    bool watchdogReset = true;
+#endif
+
+    if (watchdogReset && hangMagic == WATCHDOG_HANG_MAGIC) {
+        sResetSlot = hangSlot;
+        debugWarn() << "Watchdog reset in slot" << (unsigned long) hangSlot;
+    }
+
+    hangMagic = 0;
+    sBudget = budget;
+    sTimeout = timeout;
+
+    EventObjectConnect(Application::instance(), loop, &sInstance, onLoop);
+
+    arm();
+}
+
+
+void Watchdog::feed()
+{
+    if (sHung) {
+        sHung = false;
+        hangMagic = 0;
+        arm();
+
+        return;
+    }
+
+#ifdef __AVR__
+    wdt_reset();
+#endif
+}
+
+
+void Watchdog::onHang()
+{
+    Debug::disableAll();
+
+    hangSlot = (uintptr_t) sSlot;
+    hangMagic = WATCHDOG_HANG_MAGIC;
+    sHung = true;
+}
+
+
+void Watchdog::exitSlot(EventEmitter::Slot previous, EventEmitter::Slot slot,
+        unsigned long start)
+{
+    unsigned long duration = micros() - start;
+
+    sSlot = previous;
+
+    if (duration <= sBudget) {
+        return;
+    }
+
+    sOverruns++;
+    sLastOverrunSlot = slot;
+
+    if (duration > sWorstDuration) {
+        sWorstDuration = duration;
+        sWorstSlot = slot;
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+
+#include <stdint.h>
+
+#ifdef __AVR__
+#    include <avr/wdt.h>
+#else
+#    define WDTO_500MS 5
+#    define WDTO_1S 6
+#    define WDTO_2S 7
+#endif
+
+#include "EventObject.hpp"
+
+
+/*
+ * Hardware watchdog plus a software deadline monitor for dispatched slots.
+ * EventEmitter::emit() brackets every slot with enterSlot()/exitSlot();
+ * slots running past the budget are counted and remembered. If the loop
+ * stops feeding the watchdog, its interrupt cuts the motors through
+ * Debug::disableAll() and records the running slot, then the next
+ * timeout resets the board. resetSlot() reports that slot after reboot.
+ * A loop that comes back before the reset arms the interrupt again on
+ * its next feed(), and the hang is forgotten.
+ */
+class Watchdog : public EventObject
+{
+
+    /* Receiver for the loop() connection, the rest of the class is static */
+    static Watchdog sInstance;
+
+    static EventEmitter::Slot volatile sSlot;
+    static volatile bool sHung;
+    static unsigned char sTimeout;
+
+    static unsigned long sBudget;
+    static unsigned long sOverruns;
+    static unsigned long sWorstDuration;
+    static EventEmitter::Slot sWorstSlot;
+    static EventEmitter::Slot sLastOverrunSlot;
+    static uintptr_t sResetSlot;
+
+
+    static void arm();
+
+    EVENT_OBJECT_SLOT(Watchdog, onLoop);
+
+
+public:
+
+    /* timeout is one of the avr-libc WDTO_* values, budget in microseconds */
+    static void begin(unsigned char timeout, unsigned long budget);
+    static void feed();
+
+    /* Called from the watchdog interrupt only */
+    static void onHang();
+
+    static void exitSlot(EventEmitter::Slot previous, EventEmitter::Slot slot,
+            unsigned long start);
+
+
+    inline static EventEmitter::Slot enterSlot(EventEmitter::Slot slot)
+    {
+        EventEmitter::Slot previous = sSlot;
+
+        sSlot = slot;
+
+        return previous;
+    }
+
+
+    inline static unsigned long budget()
+    {
+        return sBudget;
+    }
+
+
+    inline static void setBudget(unsigned long value)
+    {
+        sBudget = value;
+    }
+
+
+    inline static unsigned long overruns()
+    {
+        return sOverruns;
+    }
+
+
+    inline static unsigned long worstDuration()
+    {
+        return sWorstDuration;
+    }
+
+
+    inline static EventEmitter::Slot worstSlot()
+    {
+        return sWorstSlot;
+    }
+
+
+    inline static EventEmitter::Slot lastOverrunSlot()
+    {
+        return sLastOverrunSlot;
+    }
+
+
+    /* Slot that hung before the last watchdog reset, 0 if none */
+    inline static uintptr_t resetSlot()
+    {
+        return sResetSlot;
+    }
+
+};
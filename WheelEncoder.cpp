@@ -0,0 +1,89 @@
+#include "Arduino.h"
+
+#include "Debug.hpp"
+#include "Application.hpp"
+
+#include "WheelEncoder.hpp"
+
+
+WheelEncoder *WheelEncoder::sEncoders[WheelEncoder::MaxEncoders];
+
+
+void WheelEncoder::onInterrupt0()
+{
+    sEncoders[0]->mTicks++;
+}
+
+
+void WheelEncoder::onInterrupt1()
+{
+    sEncoders[1]->mTicks++;
+}
+
+
+void WheelEncoder::onStarted()
+{
+    unsigned char n = 0;
+
+    while (n < MaxEncoders && sEncoders[n] != this) {
+        n++;
+    }
+
+    if (n == MaxEncoders) {
+        return;
+    }
+
+    pinMode(mPin, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(mPin),
+            n == 0 ? &onInterrupt0 : &onInterrupt1, RISING);
+}
+
+
+WheelEncoder::WheelEncoder(unsigned char pin)
+    : EventObject(),
+    mPin(pin),
+    mTicks(0),
+    mLastTicks(0)
+{
+    unsigned char n = 0;
+
+    while (n < MaxEncoders && sEncoders[n] != nullptr) {
+        n++;
+    }
+
+    /* One ISR per slot: refuse rather than write past sEncoders */
+
+    if (n == MaxEncoders) {
+        Debug::panic(__FILE__, __LINE__, "too many WheelEncoders");
+
+        return;
+    }
+
+    sEncoders[n] = this;
+
+    EventObjectConnect(Application::instance(), started, this, onStarted);
+}
+
+
+uint16_t WheelEncoder::ticks() const
+{
+    uint16_t value;
+
+    do {
+        value = mTicks;
+    } while (value != mTicks);
+
+    return value;
+}
+
+
+/* Return the ticks counted since the previous call */
+uint16_t WheelEncoder::takeTicks()
+{
+    uint16_t value = ticks();
+    uint16_t delta = value - mLastTicks;
+
+    mLastTicks = value;
+
+    return delta;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+
+#include <stdint.h>
+
+#include "EventObject.hpp"
+
+
+/*
+ * Single channel wheel encoder counted on the rising edges of an external
+ * interrupt (attachInterrupt), so the pin must have one: 2, 3 or 18 to
+ * 21 on the Mega. The ISR is the only writer of the tick counter, so
+ * readers get a consistent value without masking interrupts by
+ * re-reading until two loads agree. At most MaxEncoders can exist.
+ */
+class WheelEncoder : public EventObject
+{
+
+    EVENT_OBJECT_SLOT(WheelEncoder, onStarted);
+
+
+    static const unsigned char MaxEncoders = 2;
+
+
+    static WheelEncoder *sEncoders[MaxEncoders];
+
+
+    const unsigned char mPin;
+
+    volatile uint16_t mTicks;
+    uint16_t mLastTicks;
+
+
+    static void onInterrupt0();
+    static void onInterrupt1();
+
+
+public:
+
+    explicit WheelEncoder(unsigned char pin);
+
+    uint16_t ticks() const;
+    uint16_t takeTicks();
+
+
+    inline unsigned char pin() const
+    {
+        return mPin;
+    }
+
+};
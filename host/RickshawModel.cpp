@@ -0,0 +1,101 @@
+#include <math.h>
+
+#include "HostBoard.hpp"
+#include "Robot.hpp"
+
+#include "RickshawModel.hpp"
+
+
+RickshawModel::RickshawModel()
+    : mHeading(0),
+    mSpeed(0),
+    mSteering(0),
+    mDistance(0),
+    mEncoderTravel(0)
+{
+
+}
+
+
+void RickshawModel::place(const Vector2f &position, float heading)
+{
+    mPosition = position;
+    mHeading = heading;
+    mSpeed = 0;
+    mSteering = 0;
+    mDistance = 0;
+    mEncoderTravel = 0;
+}
+
+
+void RickshawModel::step(float seconds)
+{
+    bool forward = HostBoard::digital(Robot::MotorForwardPin);
+    bool backward = HostBoard::digital(Robot::MotorBackwardPin);
+    float drive = HostBoard::analog(Robot::MotorPwmPin) / 255.0f;
+    int angle = HostBoard::servo(Robot::ServoPin);
+
+    /* RickshawController's default end stops: 0 left, 90 ahead, 180 right */
+
+    float target = forward == backward ? 0 :
+        forward ? drive * MaxSpeed : -drive * MaxSpeed;
+    float steering = angle < 0 ? 0 : (90 - angle) / 90.0f * MaxSteering;
+    float slew = SteeringRate * seconds;
+
+    mSpeed += (target - mSpeed) * (1 - expf(-seconds / TimeConstant));
+
+    if (steering > mSteering + slew) {
+        mSteering += slew;
+    } else if (steering < mSteering - slew) {
+        mSteering -= slew;
+    } else {
+        mSteering = steering;
+    }
+
+    float slip = atanf(tanf(mSteering) / 2);
+    float travel = mSpeed * seconds;
+
+    mPosition += Vector2f(cosf(mHeading + slip), sinf(mHeading + slip)) *
+        travel;
+    mHeading += travel * cosf(slip) * tanf(mSteering) / WheelBase;
+    mDistance += fabsf(travel);
+
+    /* The single channel encoder ticks either way */
+
+    mEncoderTravel += fabsf(travel);
+
+    while (mEncoderTravel >= Robot::EncoderTickLength) {
+        mEncoderTravel -= Robot::EncoderTickLength;
+        HostBoard::interrupt(digitalPinToInterrupt(Robot::EncoderPin));
+    }
+}
+
+
+void RickshawModel::halt(const Vector2f &position, float heading)
+{
+    mPosition = position;
+    mHeading = heading;
+    mSpeed = 0;
+}
+
+
+Vector2f RickshawModel::toWorld(const Vector2f &point) const
+{
+    float c = cosf(mHeading);
+    float s = sinf(mHeading);
+
+    return mPosition + Vector2f(point.x() * c - point.y() * s,
+            point.x() * s + point.y() * c);
+}
+
+
+void RickshawModel::outline(Vector2f *corners) const
+{
+    float x = Robot::BodyLength / 2;
+    float y = Robot::BodyWidth / 2;
+
+    corners[0] = toWorld(Vector2f(-x, -y));
+    corners[1] = toWorld(Vector2f(x, -y));
+    corners[2] = toWorld(Vector2f(x, y));
+    corners[3] = toWorld(Vector2f(-x, y));
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+
+#include "Vector2f.hpp"
+
+
+/*
+ * Kinematics of the rickshaw for the host simulation, driven by what
+ * RickshawController wrote to the board: the PWM and direction pins set
+ * the target speed, reached through a first order motor lag, and the
+ * servo angle sets the steering, slewed at the servo's rate. The wheel
+ * encoder interrupt fires every Robot::EncoderTickLength. Motion is a
+ * bicycle model referenced to the centre of the body; the pose is in mm
+ * and radians counterclockwise, like World.
+ */
+class RickshawModel
+{
+
+public:
+
+    static constexpr float MaxSpeed = 1500;         /* mm/s at full PWM */
+    static constexpr float TimeConstant = 0.15;     /* s */
+    static constexpr float WheelBase = 180;         /* mm */
+    static constexpr float MaxSteering = 0.52;      /* rad at the end stops */
+    static constexpr float SteeringRate = 10.5;     /* rad/s */
+
+
+private:
+
+    Vector2f mPosition;
+    float mHeading;
+    float mSpeed;
+    float mSteering;
+    float mDistance;
+    float mEncoderTravel;
+
+
+public:
+
+    explicit RickshawModel();
+
+    void place(const Vector2f &position, float heading);
+    void step(float seconds);
+
+    /* Put the body back to a pose it left and stop it, after a crash */
+    void halt(const Vector2f &position, float heading);
+
+    /* Map a point from the body frame, mm forward and left, to the world */
+    Vector2f toWorld(const Vector2f &point) const;
+
+    /* Corners of the body, counterclockwise */
+    void outline(Vector2f *corners) const;
+
+
+    inline const Vector2f &position() const
+    {
+        return mPosition;
+    }
+
+
+    inline float heading() const
+    {
+        return mHeading;
+    }
+
+
+    /* mm/s, negative when reversing */
+    inline float speed() const
+    {
+        return mSpeed;
+    }
+
+
+    /* rad, positive to the left */
+    inline float steering() const
+    {
+        return mSteering;
+    }
+
+
+    /* mm travelled either way */
+    inline float distance() const
+    {
+        return mDistance;
+    }
+
+
+};
@@ -0,0 +1,338 @@
+#include <math.h>
+#include <string.h>
+
+#include "HostBoard.hpp"
+
+#include "SimulatedTof.hpp"
+
+
+/* VL53L0X_decode_timeout() */
+static uint32_t decodeTimeout(uint16_t value)
+{
+    return (uint32_t) ((value & 0x00FF) << ((value & 0xFF00) >> 8)) + 1;
+}
+
+
+/* VL53L0X_calc_timeout_us() */
+static uint32_t timeoutUs(uint32_t mclks, uint8_t vcselPeriod)
+{
+    uint32_t macroPeriodNs = (2304UL * vcselPeriod * 1655 + 500) / 1000;
+
+    return (mclks * macroPeriodNs + 500) / 1000;
+}
+
+
+bool SimulatedTof::released() const
+{
+    return HostBoard::mode(mXshutPin) == INPUT ||
+        HostBoard::digital(mXshutPin) == HIGH;
+}
+
+
+void SimulatedTof::powerOn()
+{
+    memset(mRegisters, 0, sizeof(mRegisters));
+
+    mBank = 0;
+    mIndex = 0;
+    mAddress = DefaultAddress;
+    mPowered = true;
+    mPoweredAt = HostBoard::time();
+    mMode = Stopped;
+    mReady = false;
+}
+
+
+uint8_t &SimulatedTof::reg(uint8_t index)
+{
+    return mRegisters[mBank != 0][index];
+}
+
+
+uint8_t SimulatedTof::reg(uint8_t index) const
+{
+    return mRegisters[mBank != 0][index];
+}
+
+
+uint16_t SimulatedTof::reg16(uint8_t index) const
+{
+    return (uint16_t) mRegisters[0][index] << 8 | mRegisters[0][index + 1];
+}
+
+
+void SimulatedTof::write(uint8_t index, uint8_t value)
+{
+    if (index == 0xFF) {
+        mBank = value;
+
+        return;
+    }
+
+    reg(index) = value;
+
+    if (mBank != 0) {
+        return;
+    }
+
+    switch (index) {
+    case 0x00:
+
+        /* SYSRANGE_START: bit 0 starts or, when continuous, stops */
+
+        if ((value & 0x06) == 0x02) {
+            mMode = BackToBack;
+            mNextResult = HostBoard::time() + budget();
+        } else if ((value & 0x06) == 0x04) {
+            mMode = Timed;
+            mNextResult = HostBoard::time() + budget();
+        } else if (value & 0x01) {
+            if (mMode == BackToBack || mMode == Timed) {
+                mMode = Stopped;
+            } else {
+                mMode = Single;
+                mNextResult = HostBoard::time() + CalibrationTime;
+            }
+        }
+
+        break;
+
+    case 0x0B:
+        if (value & 0x01) {
+            mReady = false;
+        }
+
+        break;
+
+    case 0x8A:
+        mAddress = value & 0x7F;
+        break;
+    }
+}
+
+
+float SimulatedTof::gaussian()
+{
+    float u[2];
+
+    for (unsigned char i = 0; i < 2; i++) {
+        mRandom ^= mRandom << 13;
+        mRandom ^= mRandom >> 17;
+        mRandom ^= mRandom << 5;
+        u[i] = ((mRandom & 0xFFFFFF) + 1) / 16777217.0f;
+    }
+
+    return sqrtf(-2 * logf(u[0])) * cosf(2 * (float) M_PI * u[1]);
+}
+
+
+void SimulatedTof::measure()
+{
+    Vector2f origin = mVehicle->toWorld(mMount);
+    float nearest = INFINITY;
+
+    for (unsigned char i = 0; i < Rays; i++) {
+        float angle = mVehicle->heading() + mMountHeading +
+            ((float) i / (Rays - 1) - 0.5f) * FieldOfView;
+
+        nearest = fminf(nearest,
+                mWorld->raycast(origin, Vector2f(cosf(angle), sinf(angle))));
+    }
+
+    uint8_t *result = mRegisters[0] + 0x14;
+    uint16_t range = 8190;
+    uint8_t status = 4;
+    float signal = 0;
+
+    if (nearest <= reach()) {
+        float sigma = (2 + 0.02f * nearest) * sqrtf(20000.0f / budget());
+        float noisy = nearest + gaussian() * sigma;
+
+        range = noisy < 0 ? 0 : noisy;
+        status = 11;
+        signal = 20 * (300 / fmaxf(nearest, 30)) * (300 / fmaxf(nearest, 30));
+    } else {
+        nearest = INFINITY;
+    }
+
+    uint16_t rate = signal > 511 ? 511 * 128 : signal * 128;
+
+    mTruth = nearest;
+    mMeasurements++;
+    mReady = true;
+
+    result[0] = status << 3;
+    result[6] = rate >> 8;
+    result[7] = rate;
+    result[8] = 0;
+    result[9] = 13;
+    result[10] = range >> 8;
+    result[11] = range;
+}
+
+
+SimulatedTof::SimulatedTof(const World *world, const RickshawModel *vehicle,
+        uint8_t xshutPin, const Vector2f &mount, float mountHeading,
+        unsigned long seed)
+    : mWorld(world),
+    mVehicle(vehicle),
+    mXshutPin(xshutPin),
+    mMount(mount),
+    mMountHeading(mountHeading),
+    mBank(0),
+    mIndex(0),
+    mAddress(DefaultAddress),
+    mPowered(false),
+    mPoweredAt(0),
+    mMode(Stopped),
+    mNextResult(0),
+    mReady(false),
+    mRandom(seed | 1),
+    mMeasurements(0),
+    mTruth(INFINITY)
+{
+
+}
+
+
+void SimulatedTof::step()
+{
+    bool released = this->released();
+
+    if (released && !mPowered) {
+        powerOn();
+    } else if (!released) {
+        mPowered = false;
+    }
+
+    if (!mPowered || mMode == Stopped ||
+            (long) (HostBoard::time() - mNextResult) < 0) {
+        return;
+    }
+
+    if (mMode == Single) {
+        mMode = Stopped;
+        measure();
+
+        return;
+    }
+
+    unsigned long period = budget();
+
+    if (mMode == Timed) {
+
+        /* An oscillator calibration of 0 leaves the period in ms */
+
+        unsigned long interval = (unsigned long) reg16(0x04) << 16 |
+            reg16(0x06);
+
+        interval *= 1000;
+        period = interval > period ? interval : period;
+    }
+
+    measure();
+
+    while ((long) (HostBoard::time() - mNextResult) >= 0) {
+        mNextResult += period;
+    }
+}
+
+
+unsigned long SimulatedTof::budget() const
+{
+    uint8_t config = mRegisters[0][0x01];
+    uint8_t prePeriod = (mRegisters[0][0x50] + 1) << 1;
+    uint8_t finalPeriod = (mRegisters[0][0x70] + 1) << 1;
+    uint32_t msrcUs = timeoutUs(mRegisters[0][0x46] + 1, prePeriod);
+    uint32_t preMclks = decodeTimeout(reg16(0x51));
+    uint32_t finalMclks = decodeTimeout(reg16(0x71));
+    unsigned long result = 1910 + 960;
+
+    if (config & 0x10) {
+        result += msrcUs + 590;
+    }
+
+    if (config & 0x08) {
+        result += 2 * (msrcUs + 690);
+    } else if (config & 0x04) {
+        result += msrcUs + 660;
+    }
+
+    if (config & 0x40) {
+        result += timeoutUs(preMclks, prePeriod) + 660;
+        finalMclks -= preMclks < finalMclks ? preMclks : finalMclks;
+    }
+
+    if (config & 0x80) {
+        result += timeoutUs(finalMclks, finalPeriod) + 550;
+    }
+
+    return result;
+}
+
+
+float SimulatedTof::reach() const
+{
+    float limit = reg16(0x44) / 128.0f;
+    float finalPeriod = (mRegisters[0][0x70] + 1) << 1;
+
+    return NominalRange * sqrtf(0.25f / fmaxf(limit, 0.05f)) *
+        sqrtf(finalPeriod / 10);
+}
+
+
+uint8_t SimulatedTof::address() const
+{
+    if (!mPowered || !released() ||
+            HostBoard::time() - mPoweredAt < BootTime) {
+        return 0;
+    }
+
+    return mAddress;
+}
+
+
+bool SimulatedTof::receive(const uint8_t *data, size_t size)
+{
+    if (size == 0) {
+        return true;
+    }
+
+    mIndex = data[0];
+
+    for (size_t i = 1; i < size; i++) {
+        write(mIndex++, data[i]);
+    }
+
+    return true;
+}
+
+
+size_t SimulatedTof::transmit(uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++, mIndex++) {
+        uint8_t value = reg(mIndex);
+
+        if (mIndex == 0x13 && mBank == 0) {
+            value = mReady ? 0x07 : 0x00;
+        } else if (mIndex == 0x83 && mBank == 0x07) {
+
+            /* SPAD info ready */
+
+            value = 0x10;
+        } else if (mIndex == 0x92) {
+
+            /* 5 aperture SPADs */
+
+            value = 0x85;
+        } else if (mIndex == 0xC0 && mBank == 0) {
+            value = 0xEE;
+        } else if (mIndex == 0x8A && mBank == 0) {
+            value = mAddress;
+        }
+
+        data[i] = value;
+    }
+
+    return size;
+}
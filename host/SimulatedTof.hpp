@@ -0,0 +1,123 @@
+#pragma once
+
+
+#include <Wire.h>
+
+#include "RickshawModel.hpp"
+#include "Vector2f.hpp"
+#include "World.hpp"
+
+
+/*
+ * VL53L0X on the host I2C bus, ranging into a World from its mounting
+ * pose on a RickshawModel. The register model covers what VL53L0XAsync
+ * touches: XSHUT and boot, the address change, the SPAD and calibration
+ * handshakes, single, back to back and timed ranging, and the interrupt
+ * and result registers. Everything else is plain storage.
+ *
+ * Measurement time comes from the same registers the driver programs, by
+ * VL53L0X_get_measurement_timing_budget_micro_seconds(), and a result is
+ * taken when its measurement ends. The range is the nearest of Rays rays
+ * across the field of view, with Gaussian noise that grows with distance
+ * and shrinks with the budget; past the reach given by the signal rate
+ * limit and the final range VCSEL period the return is lost.
+ */
+class SimulatedTof : public TwoWireDevice
+{
+
+public:
+
+    static const uint8_t DefaultAddress = 0x29;
+
+    /* Microseconds from XSHUT release to the first acknowledge */
+    static const unsigned long BootTime = 1200;
+
+    /* Microseconds a single reference calibration takes */
+    static const unsigned long CalibrationTime = 1000;
+
+    static const unsigned char Rays = 5;
+    static constexpr float FieldOfView = 0.44;      /* rad, 25 degrees */
+
+    /* mm of reach at 0.25 MCPS and a 10 PCLK final range period */
+    static constexpr float NominalRange = 1200;
+
+
+private:
+
+    enum Mode
+    {
+        Stopped,
+        Single,
+        BackToBack,
+        Timed
+    };
+
+
+    const World * const mWorld;
+    const RickshawModel * const mVehicle;
+    const uint8_t mXshutPin;
+    const Vector2f mMount;
+    const float mMountHeading;
+
+    /* Bank 0 and, shared, every other bank selected through 0xFF */
+    uint8_t mRegisters[2][256];
+    uint8_t mBank;
+    uint8_t mIndex;
+    uint8_t mAddress;
+
+    bool mPowered;
+    unsigned long mPoweredAt;
+
+    unsigned char mMode;
+    unsigned long mNextResult;
+    bool mReady;
+
+    unsigned long mRandom;
+    unsigned long mMeasurements;
+    float mTruth;
+
+
+    bool released() const;
+    void powerOn();
+    uint8_t &reg(uint8_t index);
+    uint8_t reg(uint8_t index) const;
+    uint16_t reg16(uint8_t index) const;
+    void write(uint8_t index, uint8_t value);
+    void measure();
+    float gaussian();
+
+
+public:
+
+    explicit SimulatedTof(const World *world, const RickshawModel *vehicle,
+            uint8_t xshutPin, const Vector2f &mount, float mountHeading,
+            unsigned long seed);
+
+    /* Catch up with HostBoard::time() */
+    void step();
+
+    /* Measurement timing budget as programmed, us */
+    unsigned long budget() const;
+
+    /* Reach as programmed, mm */
+    float reach() const;
+
+    virtual uint8_t address() const override;
+    virtual bool receive(const uint8_t *data, size_t size) override;
+    virtual size_t transmit(uint8_t *data, size_t size) override;
+
+
+    inline unsigned long measurements() const
+    {
+        return mMeasurements;
+    }
+
+
+    /* Noise free distance of the latest measurement, INFINITY if lost */
+    inline float truth() const
+    {
+        return mTruth;
+    }
+
+
+};
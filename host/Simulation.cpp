@@ -0,0 +1,141 @@
+#include <math.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#    include <x86intrin.h>
+#endif
+
+#include <Wire.h>
+
+#include "Application.hpp"
+#include "HostBoard.hpp"
+#include "I2CBus.hpp"
+
+#include "Simulation.hpp"
+
+
+static_assert(Robot::SensorsCount == 3,
+        "Simulation::Simulation() initialises the sensors one by one");
+
+
+static unsigned long long cycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec * 1000000000ULL + now.tv_nsec;
+#endif
+}
+
+
+static Vector2f mount(unsigned char position)
+{
+    return Vector2f(Robot::Sensors[position].x, Robot::Sensors[position].y);
+}
+
+
+static float mountHeading(unsigned char position)
+{
+    return Robot::Sensors[position].heading * (float) M_PI / 180;
+}
+
+
+void Simulation::physics()
+{
+    while (HostBoard::time() - mPhysicsTime >= PhysicsStep) {
+        Vector2f position = mVehicle.position();
+        float heading = mVehicle.heading();
+        Vector2f corners[4];
+
+        mPhysicsTime += PhysicsStep;
+        mWorld->step(PhysicsStep / 1e6f);
+        mVehicle.step(PhysicsStep / 1e6f);
+        mVehicle.outline(corners);
+        mClearance = mWorld->clearance(corners, 4);
+
+        if (mClearance == 0) {
+            if (!mColliding) {
+                mCollisions++;
+            }
+
+            mVehicle.halt(position, heading);
+        }
+
+        mColliding = mClearance == 0;
+        mMinimumClearance = fminf(mMinimumClearance, mClearance);
+    }
+}
+
+
+Simulation::Simulation(World *world, const Vector2f &position, float heading,
+        unsigned long seed)
+    : mWorld(world),
+    mVehicle(),
+    mTofs{
+        SimulatedTof(world, &mVehicle, Robot::Sensors[0].xshutPin, mount(0),
+                mountHeading(0), seed * Robot::SensorsCount),
+        SimulatedTof(world, &mVehicle, Robot::Sensors[1].xshutPin, mount(1),
+                mountHeading(1), seed * Robot::SensorsCount + 1),
+        SimulatedTof(world, &mVehicle, Robot::Sensors[2].xshutPin, mount(2),
+                mountHeading(2), seed * Robot::SensorsCount + 2)
+    },
+    mRobot(),
+    mPhysicsTime(HostBoard::time()),
+    mLoops(0),
+    mFirmwareCycles(0),
+    mCollisions(0),
+    mColliding(false),
+    mClearance(INFINITY),
+    mMinimumClearance(INFINITY)
+{
+    mVehicle.place(position, heading);
+
+    for (unsigned char i = 0; i < Robot::SensorsCount; i++) {
+        Wire.attach(&mTofs[i]);
+    }
+}
+
+
+Simulation::~Simulation()
+{
+    for (unsigned char i = 0; i < Robot::SensorsCount; i++) {
+        Wire.detach(&mTofs[i]);
+    }
+}
+
+
+void Simulation::begin()
+{
+    I2CBus::begin();
+    Wire.setTransactionTime(I2CTransactionTime);
+    Application::instance()->started()->emit();
+}
+
+
+void Simulation::loop()
+{
+    unsigned long long started = cycles();
+
+    Application::instance()->exec();
+    mFirmwareCycles += cycles() - started;
+    HostBoard::advance(LoopCost);
+    physics();
+
+    for (unsigned char i = 0; i < Robot::SensorsCount; i++) {
+        mTofs[i].step();
+    }
+
+    mLoops++;
+}
+
+
+void Simulation::run(unsigned long until)
+{
+    while ((long) (HostBoard::time() - until) < 0) {
+        loop();
+    }
+}
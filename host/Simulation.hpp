@@ -0,0 +1,128 @@
+#pragma once
+
+
+#include "Robot.hpp"
+#include "RickshawModel.hpp"
+#include "SimulatedTof.hpp"
+#include "World.hpp"
+
+
+/*
+ * Closed loop host simulation of the whole Robot. Every loop() costs
+ * LoopCost of virtual time plus whatever the I2C transactions in it
+ * took; in between, the rickshaw follows the pins RickshawController
+ * wrote, in PhysicsStep slices, and the sensors range into the world
+ * from its new pose. A crash stops the body where it touched.
+ *
+ * The firmware's own share of the host CPU is counted separately, so
+ * changes to it can be compared without the cost of the world.
+ *
+ * HostBoard::reset() must come before the construction, and a process
+ * holds one Simulation at a time: the sensors share Wire.
+ */
+class Simulation
+{
+
+public:
+
+    static const unsigned long LoopCost = 300;      /* us */
+    static const unsigned long PhysicsStep = 1000;  /* us */
+    static const unsigned long I2CTransactionTime = 100;
+
+
+private:
+
+    World *mWorld;
+    RickshawModel mVehicle;
+    SimulatedTof mTofs[Robot::SensorsCount];
+    Robot mRobot;
+
+    unsigned long mPhysicsTime;
+    unsigned long mLoops;
+    unsigned long long mFirmwareCycles;
+    unsigned long mCollisions;
+    bool mColliding;
+    float mClearance;
+    float mMinimumClearance;
+
+
+    void physics();
+
+
+public:
+
+    explicit Simulation(World *world, const Vector2f &position,
+            float heading, unsigned long seed);
+    ~Simulation();
+
+    /* Boot the robot as setup() does */
+    void begin();
+
+    /* One loop() and the world up to its end */
+    void loop();
+
+    /* Loop until HostBoard::time() reaches until */
+    void run(unsigned long until);
+
+
+    inline World &world()
+    {
+        return *mWorld;
+    }
+
+
+    inline RickshawModel &vehicle()
+    {
+        return mVehicle;
+    }
+
+
+    inline SimulatedTof &tof(unsigned char position)
+    {
+        return mTofs[position];
+    }
+
+
+    inline Robot &robot()
+    {
+        return mRobot;
+    }
+
+
+    inline unsigned long loops() const
+    {
+        return mLoops;
+    }
+
+
+    /*
+     * Host cycles spent in Application::exec(), by the time stamp
+     * counter where there is one and in nanoseconds otherwise
+     */
+    inline unsigned long long firmwareCycles() const
+    {
+        return mFirmwareCycles;
+    }
+
+
+    /* Times the body ran into a wall or was hit */
+    inline unsigned long collisions() const
+    {
+        return mCollisions;
+    }
+
+
+    /* mm between the body and the nearest wall, now and at worst */
+    inline float clearance() const
+    {
+        return mClearance;
+    }
+
+
+    inline float minimumClearance() const
+    {
+        return mMinimumClearance;
+    }
+
+
+};
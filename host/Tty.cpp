@@ -0,0 +1,91 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "Tty.hpp"
+
+
+static void makeRaw(int fd, speed_t speed)
+{
+    struct termios tio;
+
+    if (tcgetattr(fd, &tio) != 0) {
+        return;
+    }
+
+    cfmakeraw(&tio);
+    cfsetspeed(&tio, speed);
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    tcsetattr(fd, TCSANOW, &tio);
+}
+
+
+static speed_t speedOf(unsigned long baud)
+{
+    switch (baud) {
+    case 9600:
+        return B9600;
+
+    case 57600:
+        return B57600;
+
+    case 230400:
+        return B230400;
+
+    default:
+        return B115200;
+    }
+}
+
+
+int openPty()
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        perror("posix_openpt");
+
+        return -1;
+    }
+
+    const char *path = ptsname(master);
+
+    /*
+     * Keep the slave open ourselves: the line discipline lives there, and
+     * the master reads EIO whenever no slave descriptor is open.
+     */
+
+    int slave = open(path, O_RDWR | O_NOCTTY);
+
+    if (slave < 0) {
+        perror(path);
+
+        return -1;
+    }
+
+    makeRaw(slave, B115200);
+    fcntl(master, F_SETFL, O_NONBLOCK);
+    printf("pty: %s\n", path);
+    fflush(stdout);
+
+    return master;
+}
+
+
+int openTty(const char *path, unsigned long baud)
+{
+    int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+
+    if (fd < 0) {
+        perror(path);
+
+        return -1;
+    }
+
+    makeRaw(fd, speedOf(baud));
+
+    return fd;
+}
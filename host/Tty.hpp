@@ -0,0 +1,11 @@
+#pragma once
+
+
+/*
+ * Serial endpoints for the host tools. openPty() creates a pseudo terminal
+ * whose slave path is printed, so the other end can be a second host tool
+ * or a real board bridged with socat; openTty() opens an existing device
+ * or pty slave. Both return a raw, non-blocking descriptor or -1.
+ */
+int openPty();
+int openTty(const char *path, unsigned long baud);
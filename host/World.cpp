@@ -0,0 +1,155 @@
+#include <math.h>
+
+#include "World.hpp"
+
+
+World::World()
+    : mCount(0),
+    mBodies(0)
+{
+
+}
+
+
+unsigned char World::addPolygon(const Vector2f *points, unsigned int count,
+        bool open, const Vector2f &velocity)
+{
+    unsigned int edges = open ? count - 1 : count;
+
+    if (mBodies == BodiesCapacity || mCount + edges > Capacity) {
+        return mBodies;
+    }
+
+    for (unsigned int i = 0; i < edges; i++) {
+        Segment &segment = mSegments[mCount++];
+
+        segment.a = points[i];
+        segment.b = points[(i + 1) % count];
+        segment.body = mBodies;
+    }
+
+    mVelocities[mBodies] = velocity;
+
+    return mBodies++;
+}
+
+
+unsigned char World::addBox(float x, float y, float width, float height,
+        const Vector2f &velocity)
+{
+    Vector2f points[] = {
+        Vector2f(x, y),
+        Vector2f(x + width, y),
+        Vector2f(x + width, y + height),
+        Vector2f(x, y + height)
+    };
+
+    return addPolygon(points, 4, false, velocity);
+}
+
+
+void World::step(float seconds)
+{
+    for (unsigned int i = 0; i < mCount; i++) {
+        Segment &segment = mSegments[i];
+        Vector2f offset = mVelocities[segment.body] * seconds;
+
+        segment.a += offset;
+        segment.b += offset;
+    }
+}
+
+
+void World::setVelocity(unsigned char body, const Vector2f &value)
+{
+    mVelocities[body] = value;
+}
+
+
+float World::cross(const Vector2f &a, const Vector2f &b)
+{
+    return a.x() * b.y() - a.y() * b.x();
+}
+
+
+float World::distance(const Vector2f &point, const Vector2f &a,
+        const Vector2f &b)
+{
+    Vector2f ab = b - a;
+    Vector2f ap = point - a;
+    float length = ab.sqrMagnitude();
+    float t = length == 0 ? 0 : ap.dot(ab) / length;
+
+    t = t < 0 ? 0 : t > 1 ? 1 : t;
+
+    return sqrtf((ap - ab * t).sqrMagnitude());
+}
+
+
+float World::distance(const Vector2f &a, const Vector2f &b,
+        const Vector2f &c, const Vector2f &d)
+{
+    float d1 = cross(b - a, c - a);
+    float d2 = cross(b - a, d - a);
+    float d3 = cross(d - c, a - c);
+    float d4 = cross(d - c, b - c);
+
+    if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) &&
+            ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0))) {
+        return 0;
+    }
+
+    float result = distance(a, c, d);
+
+    result = fminf(result, distance(b, c, d));
+    result = fminf(result, distance(c, a, b));
+
+    return fminf(result, distance(d, a, b));
+}
+
+
+float World::raycast(const Vector2f &origin, const Vector2f &direction) const
+{
+    float nearest = INFINITY;
+
+    for (unsigned int i = 0; i < mCount; i++) {
+        const Segment &segment = mSegments[i];
+        Vector2f edge = segment.b - segment.a;
+        float denominator = cross(direction, edge);
+
+        if (denominator == 0) {
+            continue;
+        }
+
+        Vector2f offset = segment.a - origin;
+        float t = cross(offset, edge) / denominator;
+        float u = cross(offset, direction) / denominator;
+
+        if (t >= 0 && u >= 0 && u <= 1 && t < nearest) {
+            nearest = t;
+        }
+    }
+
+    return nearest;
+}
+
+
+float World::clearance(const Vector2f *points, unsigned int count) const
+{
+    float nearest = INFINITY;
+
+    for (unsigned int i = 0; i < mCount; i++) {
+        const Segment &segment = mSegments[i];
+
+        for (unsigned int j = 0; j < count; j++) {
+            float value = distance(points[j], points[(j + 1) % count],
+                    segment.a, segment.b);
+
+            if (value < nearest) {
+                nearest = value;
+            }
+        }
+    }
+
+    return nearest;
+}
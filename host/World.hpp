@@ -0,0 +1,88 @@
+#pragma once
+
+
+#include "Vector2f.hpp"
+
+
+/*
+ * Flat world of line segments for the host simulation, in mm. Segments
+ * are added as polygons, each of which is a body that may move at a
+ * constant velocity; step() moves them. Queries are brute force over all
+ * segments, which is plenty for rooms of a few hundred walls.
+ */
+class World
+{
+
+public:
+
+    static const unsigned int Capacity = 512;
+    static const unsigned char BodiesCapacity = 32;
+
+
+private:
+
+    struct Segment
+    {
+        Vector2f a;
+        Vector2f b;
+        unsigned char body;
+    };
+
+
+    Segment mSegments[Capacity];
+    unsigned int mCount;
+
+    Vector2f mVelocities[BodiesCapacity];
+    unsigned char mBodies;
+
+
+public:
+
+    explicit World();
+
+    /*
+     * Add the outline through count points, closed back to the first
+     * one unless open, moving at velocity mm/s. Return the body index.
+     */
+    unsigned char addPolygon(const Vector2f *points, unsigned int count,
+            bool open = false, const Vector2f &velocity = Vector2f());
+
+    /* Axis aligned rectangle from its lower left corner */
+    unsigned char addBox(float x, float y, float width, float height,
+            const Vector2f &velocity = Vector2f());
+
+    void step(float seconds);
+
+    /* Distance along the unit direction to the nearest wall, or INFINITY */
+    float raycast(const Vector2f &origin, const Vector2f &direction) const;
+
+    /*
+     * Distance from the closed outline through count points to the
+     * nearest wall, 0 when they touch or cross
+     */
+    float clearance(const Vector2f *points, unsigned int count) const;
+
+    void setVelocity(unsigned char body, const Vector2f &value);
+
+
+    inline unsigned int count() const
+    {
+        return mCount;
+    }
+
+
+    inline const Vector2f &velocity(unsigned char body) const
+    {
+        return mVelocities[body];
+    }
+
+
+    static float cross(const Vector2f &a, const Vector2f &b);
+    static float distance(const Vector2f &point, const Vector2f &a,
+            const Vector2f &b);
+
+    /* Distance between segments ab and cd, 0 when they cross */
+    static float distance(const Vector2f &a, const Vector2f &b,
+            const Vector2f &c, const Vector2f &d);
+
+};
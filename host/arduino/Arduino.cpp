@@ -0,0 +1,448 @@
+#include "Arduino.h"
+
+#include "Servo.h"
+#include "Wire.h"
+
+#include "HostBoard.hpp"
+
+
+unsigned long HostBoard::sMicros = 0;
+uint8_t HostBoard::sModes[PinsCount];
+uint8_t HostBoard::sDigital[PinsCount];
+int HostBoard::sAnalog[PinsCount];
+int HostBoard::sServo[PinsCount];
+void (*HostBoard::sInterrupts[InterruptsCount])();
+HostBoard::AnalogListener HostBoard::sAnalogListener = nullptr;
+
+
+HardwareSerial Serial(stderr);
+HardwareSerial Serial1;
+TwoWire Wire;
+
+
+void HostBoard::reset()
+{
+    sMicros = 0;
+
+    for (uint8_t i = 0; i < PinsCount; i++) {
+        sModes[i] = INPUT;
+        sDigital[i] = LOW;
+        sAnalog[i] = 0;
+        sServo[i] = -1;
+    }
+
+    for (uint8_t i = 0; i < InterruptsCount; i++) {
+        sInterrupts[i] = nullptr;
+    }
+}
+
+
+void HostBoard::interrupt(uint8_t interrupt)
+{
+    if (interrupt < InterruptsCount && sInterrupts[interrupt] != nullptr) {
+        sInterrupts[interrupt]();
+    }
+}
+
+
+unsigned long millis()
+{
+    return HostBoard::sMicros / 1000;
+}
+
+
+unsigned long micros()
+{
+    return HostBoard::sMicros;
+}
+
+
+void delay(unsigned long ms)
+{
+    HostBoard::sMicros += ms * 1000;
+}
+
+
+void delayMicroseconds(unsigned int us)
+{
+    HostBoard::sMicros += us;
+}
+
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    HostBoard::sModes[pin] = mode;
+
+    if (mode == INPUT_PULLUP) {
+        HostBoard::sDigital[pin] = HIGH;
+    }
+}
+
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    HostBoard::sDigital[pin] = value != LOW;
+}
+
+
+int digitalRead(uint8_t pin)
+{
+    return HostBoard::sDigital[pin];
+}
+
+
+void analogWrite(uint8_t pin, int value)
+{
+    HostBoard::sAnalog[pin] = value;
+
+    if (HostBoard::sAnalogListener != nullptr) {
+        HostBoard::sAnalogListener(pin, value);
+    }
+}
+
+
+void attachInterrupt(uint8_t interrupt, void (*isr)(), int)
+{
+    if (interrupt < HostBoard::InterruptsCount) {
+        HostBoard::sInterrupts[interrupt] = isr;
+    }
+}
+
+
+void detachInterrupt(uint8_t interrupt)
+{
+    if (interrupt < HostBoard::InterruptsCount) {
+        HostBoard::sInterrupts[interrupt] = nullptr;
+    }
+}
+
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        write(buffer[i]);
+    }
+
+    return size;
+}
+
+
+size_t Print::print(const char *value)
+{
+    return write(value);
+}
+
+
+size_t Print::print(char value)
+{
+    return write((uint8_t) value);
+}
+
+
+size_t Print::print(int value, int base)
+{
+    return print((long) value, base);
+}
+
+
+size_t Print::print(unsigned int value, int base)
+{
+    return print((unsigned long) value, base);
+}
+
+
+size_t Print::print(long value, int base)
+{
+    char text[24];
+
+    snprintf(text, sizeof(text), base == HEX ? "%lX" : "%ld", value);
+
+    return write(text);
+}
+
+
+size_t Print::print(unsigned long value, int base)
+{
+    char text[24];
+
+    snprintf(text, sizeof(text), base == HEX ? "%lX" : "%lu", value);
+
+    return write(text);
+}
+
+
+size_t Print::print(double value, int digits)
+{
+    char text[32];
+
+    snprintf(text, sizeof(text), "%.*f", digits, value);
+
+    return write(text);
+}
+
+
+size_t Print::println()
+{
+    return write("\r\n");
+}
+
+
+HardwareSerial::HardwareSerial(FILE *echo)
+    : mRxHead(0),
+    mRxTail(0),
+    mTxSize(0),
+    mEcho(echo)
+{
+
+}
+
+
+void HardwareSerial::begin(unsigned long)
+{
+
+}
+
+
+void HardwareSerial::end()
+{
+
+}
+
+
+size_t HardwareSerial::write(uint8_t value)
+{
+    if (mEcho != nullptr) {
+        fputc(value, mEcho);
+
+        return 1;
+    }
+
+    if (mTxSize == BufferSize) {
+        return 0;
+    }
+
+    mTx[mTxSize++] = value;
+
+    return 1;
+}
+
+
+int HardwareSerial::available()
+{
+    return mRxTail - mRxHead;
+}
+
+
+int HardwareSerial::read()
+{
+    if (mRxHead == mRxTail) {
+        return -1;
+    }
+
+    return mRx[mRxHead++];
+}
+
+
+int HardwareSerial::peek()
+{
+    return mRxHead == mRxTail ? -1 : mRx[mRxHead];
+}
+
+
+int HardwareSerial::availableForWrite()
+{
+    return mEcho != nullptr ? SERIAL_TX_BUFFER_SIZE - 1 : BufferSize - mTxSize;
+}
+
+
+void HardwareSerial::receive(const uint8_t *data, size_t size)
+{
+    if (mRxHead == mRxTail) {
+        mRxHead = 0;
+        mRxTail = 0;
+    }
+
+    if (size > BufferSize - mRxTail) {
+        size = BufferSize - mRxTail;
+    }
+
+    memcpy(mRx + mRxTail, data, size);
+    mRxTail += size;
+}
+
+
+size_t HardwareSerial::takeTx(uint8_t *data, size_t size)
+{
+    if (size > mTxSize) {
+        size = mTxSize;
+    }
+
+    memcpy(data, mTx, size);
+    memmove(mTx, mTx + size, mTxSize - size);
+    mTxSize -= size;
+
+    return size;
+}
+
+
+uint8_t Servo::attach(int pin)
+{
+    mPin = pin;
+    HostBoard::sServo[pin] = 90;
+
+    return 0;
+}
+
+
+void Servo::detach()
+{
+    if (mPin >= 0) {
+        HostBoard::sServo[mPin] = -1;
+        mPin = -1;
+    }
+}
+
+
+void Servo::write(int angle)
+{
+    if (mPin >= 0) {
+        HostBoard::sServo[mPin] = angle < 0 ? 0 : angle > 180 ? 180 : angle;
+    }
+}
+
+
+void Servo::writeMicroseconds(int value)
+{
+    write((value - 544) * 180 / (2400 - 544));
+}
+
+
+TwoWire::TwoWire()
+    : mDevicesCount(0),
+    mAddress(0),
+    mTxSize(0),
+    mRxSize(0),
+    mRxIndex(0),
+    mTransactionTime(0)
+{
+
+}
+
+
+TwoWireDevice *TwoWire::device(uint8_t address) const
+{
+    for (uint8_t i = 0; i < mDevicesCount; i++) {
+        if (mDevices[i]->address() == address) {
+            return mDevices[i];
+        }
+    }
+
+    return nullptr;
+}
+
+
+void TwoWire::attach(TwoWireDevice *device)
+{
+    if (mDevicesCount < DevicesSize) {
+        mDevices[mDevicesCount++] = device;
+    }
+}
+
+
+void TwoWire::detach(TwoWireDevice *device)
+{
+    for (uint8_t i = 0; i < mDevicesCount; i++) {
+        if (mDevices[i] == device) {
+            mDevices[i] = mDevices[--mDevicesCount];
+
+            return;
+        }
+    }
+}
+
+
+void TwoWire::begin()
+{
+
+}
+
+
+void TwoWire::end()
+{
+
+}
+
+
+void TwoWire::setClock(uint32_t)
+{
+
+}
+
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    mAddress = address;
+    mTxSize = 0;
+}
+
+
+size_t TwoWire::write(uint8_t value)
+{
+    if (mTxSize == BufferSize) {
+        return 0;
+    }
+
+    mTx[mTxSize++] = value;
+
+    return 1;
+}
+
+
+/* Same codes as the AVR Wire: 0 success, 2 address NACK, 3 data NACK */
+uint8_t TwoWire::endTransmission(bool)
+{
+    TwoWireDevice *slave = device(mAddress);
+
+    HostBoard::advance(mTransactionTime);
+
+    if (slave == nullptr) {
+        return 2;
+    }
+
+    return slave->receive(mTx, mTxSize) ? 0 : 3;
+}
+
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t size)
+{
+    TwoWireDevice *slave = device(address);
+
+    HostBoard::advance(mTransactionTime);
+
+    mRxIndex = 0;
+    mRxSize = 0;
+
+    if (slave == nullptr) {
+        return 0;
+    }
+
+    if (size > BufferSize) {
+        size = BufferSize;
+    }
+
+    mRxSize = slave->transmit(mRx, size);
+
+    return mRxSize;
+}
+
+
+int TwoWire::available()
+{
+    return mRxSize - mRxIndex;
+}
+
+
+int TwoWire::read()
+{
+    return mRxIndex < mRxSize ? mRx[mRxIndex++] : -1;
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+
+/*
+ * Just enough of the Arduino core to build the sketch sources on a host.
+ * Time is virtual and only moves through HostBoard::advance() and
+ * delay(); pins, PWM duty cycles and servo angles are recorded for the
+ * host programs to inspect, see HostBoard.hpp.
+ */
+
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+
+#ifndef F_CPU
+#    define F_CPU 16000000UL
+#endif
+
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+
+#define HIGH 1
+#define LOW 0
+
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define DEC 10
+#define HEX 16
+
+#define LED_BUILTIN 13
+#define SDA 20
+#define SCL 21
+
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *) (address))
+#define pgm_read_word(address) (*(const uint16_t *) (address))
+
+#define digitalPinToInterrupt(pin) (pin)
+
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+
+void attachInterrupt(uint8_t interrupt, void (*isr)(), int mode);
+void detachInterrupt(uint8_t interrupt);
+
+
+inline void noInterrupts()
+{
+
+}
+
+
+inline void interrupts()
+{
+
+}
+
+
+class Print
+{
+
+public:
+
+    virtual ~Print()
+    {
+
+    }
+
+
+    virtual size_t write(uint8_t value) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+
+
+    inline size_t write(const char *value)
+    {
+        return write((const uint8_t *) value, strlen(value));
+    }
+
+
+    size_t print(const char *value);
+    size_t print(char value);
+    size_t print(int value, int base = DEC);
+    size_t print(unsigned int value, int base = DEC);
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+    size_t println();
+
+
+    template<typename T>
+    inline size_t println(T value)
+    {
+        return print(value) + println();
+    }
+
+
+    template<typename T>
+    inline size_t println(T value, int format)
+    {
+        return print(value, format) + println();
+    }
+
+
+};
+
+
+class Stream : public Print
+{
+
+public:
+
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+};
+
+
+/*
+ * Bytes written are appended to tx(), or echoed to a FILE when one is
+ * set; bytes to be read are queued with receive().
+ */
+#define SERIAL_TX_BUFFER_SIZE 64
+
+
+class HardwareSerial : public Stream
+{
+
+    static const size_t BufferSize = 1024;
+
+
+    uint8_t mRx[BufferSize];
+    size_t mRxHead;
+    size_t mRxTail;
+
+    uint8_t mTx[BufferSize];
+    size_t mTxSize;
+
+    FILE *mEcho;
+
+
+public:
+
+    explicit HardwareSerial(FILE *echo = nullptr);
+
+    void begin(unsigned long baud);
+    void end();
+
+    virtual size_t write(uint8_t value) override;
+    virtual int available() override;
+    virtual int read() override;
+    virtual int peek() override;
+
+    int availableForWrite();
+
+    void receive(const uint8_t *data, size_t size);
+    size_t takeTx(uint8_t *data, size_t size);
+
+
+    using Print::write;
+
+
+    inline operator bool() const
+    {
+        return true;
+    }
+
+
+    inline void setEcho(FILE *value)
+    {
+        mEcho = value;
+    }
+
+
+};
+
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
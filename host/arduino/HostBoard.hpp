@@ -0,0 +1,107 @@
+#pragma once
+
+
+#include "Arduino.h"
+
+
+/*
+ * State of the simulated board behind the host Arduino core. Programs
+ * drive time with advance() and read back the outputs the firmware
+ * wrote; listeners see every analogWrite() as it happens, which is how
+ * latencies are timed to the microsecond.
+ */
+class HostBoard
+{
+
+public:
+
+    static const uint8_t PinsCount = 70;
+    static const uint8_t InterruptsCount = 6;
+
+
+    typedef void (*AnalogListener)(uint8_t pin, int value);
+
+
+private:
+
+    static unsigned long sMicros;
+
+    static uint8_t sModes[PinsCount];
+    static uint8_t sDigital[PinsCount];
+    static int sAnalog[PinsCount];
+    static int sServo[PinsCount];
+    static void (*sInterrupts[InterruptsCount])();
+
+    static AnalogListener sAnalogListener;
+
+
+    friend unsigned long millis();
+    friend unsigned long micros();
+    friend void delay(unsigned long ms);
+    friend void delayMicroseconds(unsigned int us);
+    friend void pinMode(uint8_t pin, uint8_t mode);
+    friend void digitalWrite(uint8_t pin, uint8_t value);
+    friend int digitalRead(uint8_t pin);
+    friend void analogWrite(uint8_t pin, int value);
+    friend void attachInterrupt(uint8_t interrupt, void (*isr)(), int mode);
+    friend void detachInterrupt(uint8_t interrupt);
+    friend class Servo;
+
+
+public:
+
+    static void reset();
+    static void interrupt(uint8_t interrupt);
+
+
+    inline static void advance(unsigned long us)
+    {
+        sMicros += us;
+    }
+
+
+    inline static unsigned long time()
+    {
+        return sMicros;
+    }
+
+
+    inline static uint8_t mode(uint8_t pin)
+    {
+        return sModes[pin];
+    }
+
+
+    inline static uint8_t digital(uint8_t pin)
+    {
+        return sDigital[pin];
+    }
+
+
+    /* Drive an input pin from outside */
+    inline static void setDigital(uint8_t pin, uint8_t value)
+    {
+        sDigital[pin] = value;
+    }
+
+
+    inline static int analog(uint8_t pin)
+    {
+        return sAnalog[pin];
+    }
+
+
+    /* Servo angle in degrees, -1 when detached */
+    inline static int servo(uint8_t pin)
+    {
+        return sServo[pin];
+    }
+
+
+    inline static void setAnalogListener(AnalogListener value)
+    {
+        sAnalogListener = value;
+    }
+
+
+};
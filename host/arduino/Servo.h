@@ -0,0 +1,35 @@
+#pragma once
+
+
+#include "Arduino.h"
+
+
+/* Angles land in HostBoard::servo(pin) */
+class Servo
+{
+
+    int mPin;
+
+
+public:
+
+    inline Servo()
+        : mPin(-1)
+    {
+
+    }
+
+
+    uint8_t attach(int pin);
+    void detach();
+    void write(int angle);
+    void writeMicroseconds(int value);
+
+
+    inline bool attached() const
+    {
+        return mPin >= 0;
+    }
+
+
+};
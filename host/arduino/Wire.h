@@ -0,0 +1,86 @@
+#pragma once
+
+
+#include "Arduino.h"
+
+
+/*
+ * A slave on the host I2C bus. receive() gets what the master wrote in
+ * one transaction and returns whether the slave acknowledged it;
+ * transmit() fills a master read and returns the number of bytes sent.
+ */
+class TwoWireDevice
+{
+
+public:
+
+    virtual ~TwoWireDevice()
+    {
+
+    }
+
+
+    virtual uint8_t address() const = 0;
+    virtual bool receive(const uint8_t *data, size_t size) = 0;
+    virtual size_t transmit(uint8_t *data, size_t size) = 0;
+
+};
+
+
+class TwoWire
+{
+
+    static const uint8_t BufferSize = 32;
+    static const uint8_t DevicesSize = 16;
+
+
+    TwoWireDevice *mDevices[DevicesSize];
+    uint8_t mDevicesCount;
+
+    uint8_t mAddress;
+    uint8_t mTx[BufferSize];
+    uint8_t mTxSize;
+    uint8_t mRx[BufferSize];
+    uint8_t mRxSize;
+    uint8_t mRxIndex;
+
+    unsigned long mTransactionTime;
+
+
+    TwoWireDevice *device(uint8_t address) const;
+
+
+public:
+
+    explicit TwoWire();
+
+    void attach(TwoWireDevice *device);
+    void detach(TwoWireDevice *device);
+
+    void begin();
+    void end();
+    void setClock(uint32_t clock);
+
+    void beginTransmission(uint8_t address);
+    size_t write(uint8_t value);
+    uint8_t endTransmission(bool stop = true);
+
+    uint8_t requestFrom(uint8_t address, uint8_t size);
+    int available();
+    int read();
+
+
+    /*
+     * Virtual microseconds every transaction takes, roughly 100 us for
+     * a short register access at 400 kHz
+     */
+    inline void setTransactionTime(unsigned long value)
+    {
+        mTransactionTime = value;
+    }
+
+
+};
+
+
+extern TwoWire Wire;
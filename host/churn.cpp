@@ -0,0 +1,529 @@
+/*
+ * Churn stress for the signal/slot core. Random connect, once, exact and
+ * wildcard disconnect, post, nested emit and Application::exec() run
+ * over hundreds of emitters, from the top level and from inside the
+ * slots they call, against a model of what EventEmitter promises:
+ *
+ *  - an emission calls, in connection order, the receivers connected
+ *    when it began that are still connected when their turn comes;
+ *  - a once() receiver is called once;
+ *  - exec() dispatches the emitters posted before it, once each, by
+ *    priority and then in posting order.
+ *
+ * The first receiver of every emitter is a probe that tells the model
+ * an emission began, so posted emissions are checked like direct ones.
+ * Throughput, peak heap and any broken invariant are reported; the exit
+ * status is non-zero on the latter.
+ *
+ *     churn [-n operations] [-e emitters] [-s seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Application.hpp"
+#include "HostBoard.hpp"
+#include "Memory.hpp"
+
+
+static const unsigned int MaxEmitters = 512;
+static const unsigned int Receivers = 64;
+static const unsigned int Slots = 4;
+static const unsigned int MaxConnections = 2500;
+static const unsigned int MaxPerEmitter = 48;
+static const unsigned int MaxDepth = 6;
+static const unsigned int MaxFrames = MaxDepth + 2;
+
+
+class Receiver : public EventObject
+{
+
+};
+
+
+struct Connection
+{
+    unsigned long serial;
+    uint16_t emitter;
+    uint8_t receiver;
+    uint8_t slot;
+    bool once;
+    bool alive;
+};
+
+
+struct Reference
+{
+    uint16_t index;
+    unsigned long serial;
+};
+
+
+struct Frame
+{
+    uint16_t emitter;
+    unsigned char depth;
+    unsigned char count;
+    unsigned char position;
+    Reference snapshot[MaxPerEmitter];
+};
+
+
+static EventEmitter sEmitters[MaxEmitters];
+static unsigned int sEmittersCount = 256;
+static Receiver sReceivers[Receivers];
+static Receiver sProbe;
+
+/* The model: connections in order per emitter */
+static Connection sConnections[MaxConnections];
+static uint16_t sFree[MaxConnections];
+static unsigned int sFreeCount;
+static unsigned long sSerial;
+static uint16_t sOrder[MaxEmitters][MaxPerEmitter];
+static unsigned char sOrderCount[MaxEmitters];
+static unsigned int sLive;
+
+/* Posted emitters per priority, and the pass exec() is dispatching */
+static uint16_t sQueues[EventEmitter::PrioritiesCount][MaxEmitters];
+static unsigned int sQueued[EventEmitter::PrioritiesCount];
+static bool sPosted[MaxEmitters];
+static uint16_t sDispatch[MaxEmitters];
+static unsigned int sDispatchCount;
+static unsigned int sDispatched;
+static bool sInExec;
+
+static Frame sFrames[MaxFrames];
+static unsigned int sFramesCount;
+static unsigned int sDepth;
+
+static unsigned long sOperations;
+static unsigned long sLimit = 2000000;
+static unsigned long sCalls;
+static unsigned long sEmissions;
+static unsigned long sErrors;
+
+
+static void fail(const char *what, unsigned int emitter)
+{
+    if (sErrors++ < 10) {
+        fprintf(stderr, "churn: %s, emitter %u, operation %lu\n", what,
+                emitter, sOperations);
+    }
+}
+
+
+static unsigned int random(unsigned int n)
+{
+    return (unsigned int) rand() % n;
+}
+
+
+static unsigned int indexOf(EventEmitter *emitter)
+{
+    return emitter - sEmitters;
+}
+
+
+static int find(unsigned int emitter, unsigned int receiver, unsigned int slot)
+{
+    for (unsigned char i = 0; i < sOrderCount[emitter]; i++) {
+        const Connection &connection = sConnections[sOrder[emitter][i]];
+
+        if (connection.receiver == receiver && connection.slot == slot) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+
+static void forget(unsigned int emitter, unsigned char position)
+{
+    uint16_t index = sOrder[emitter][position];
+
+    sConnections[index].alive = false;
+    sFree[sFreeCount++] = index;
+    sLive--;
+
+    for (unsigned char i = position + 1; i < sOrderCount[emitter]; i++) {
+        sOrder[emitter][i - 1] = sOrder[emitter][i];
+    }
+
+    sOrderCount[emitter]--;
+}
+
+
+static bool alive(const Reference &reference)
+{
+    const Connection &connection = sConnections[reference.index];
+
+    return connection.alive && connection.serial == reference.serial;
+}
+
+
+/* Pop the frames of emissions begun at depth or deeper: they returned */
+static void close(unsigned int depth)
+{
+    while (sFramesCount > 0 && sFrames[sFramesCount - 1].depth >= depth) {
+        Frame &frame = sFrames[--sFramesCount];
+
+        for (unsigned char i = frame.position; i < frame.count; i++) {
+            if (alive(frame.snapshot[i])) {
+                fail("connected receiver not called", frame.emitter);
+
+                break;
+            }
+        }
+    }
+}
+
+
+static void onProbe(EventObject *)
+{
+    unsigned int emitter = indexOf(EventEmitter::sender());
+
+    sEmissions++;
+    close(sDepth);
+
+    if (sInExec && sDepth == 0) {
+        if (sDispatched == sDispatchCount ||
+                sDispatch[sDispatched] != emitter) {
+            fail("dispatched out of order", emitter);
+        } else {
+            sDispatched++;
+        }
+
+        sPosted[emitter] = false;
+    }
+
+    if (sFramesCount == MaxFrames) {
+        fail("emissions nested too deep", emitter);
+
+        return;
+    }
+
+    Frame &frame = sFrames[sFramesCount++];
+
+    frame.emitter = emitter;
+    frame.depth = sDepth;
+    frame.count = sOrderCount[emitter];
+    frame.position = 0;
+
+    for (unsigned char i = 0; i < frame.count; i++) {
+        frame.snapshot[i].index = sOrder[emitter][i];
+        frame.snapshot[i].serial = sConnections[sOrder[emitter][i]].serial;
+    }
+}
+
+
+static void operate(unsigned int depth);
+
+
+static void called(EventObject *receiver, unsigned int slot)
+{
+    unsigned int emitter = indexOf(EventEmitter::sender());
+
+    sCalls++;
+    close(sDepth + 1);
+
+    if (sFramesCount == 0 || sFrames[sFramesCount - 1].emitter != emitter) {
+        fail("call outside its emission", emitter);
+
+        return;
+    }
+
+    Frame &frame = sFrames[sFramesCount - 1];
+
+    while (frame.position < frame.count &&
+            !alive(frame.snapshot[frame.position])) {
+        frame.position++;
+    }
+
+    if (frame.position == frame.count) {
+        fail("disconnected or new receiver called", emitter);
+
+        return;
+    }
+
+    const Connection &connection =
+        sConnections[frame.snapshot[frame.position++].index];
+
+    if (&sReceivers[connection.receiver] != receiver ||
+            connection.slot != slot) {
+        fail("receivers called out of order", emitter);
+
+        return;
+    }
+
+    if (connection.once) {
+        forget(emitter, find(emitter, connection.receiver, slot));
+    }
+
+    /* Slots churn too, less and less the deeper they are */
+
+    sDepth++;
+
+    if (sDepth <= MaxDepth && random(2 << sDepth) == 0) {
+        operate(sDepth);
+    }
+
+    sDepth--;
+}
+
+
+template<unsigned int S>
+static void onSlot(EventObject *receiver)
+{
+    called(receiver, S);
+}
+
+
+static const EventEmitter::Slot sSlots[Slots] = {
+    &onSlot<0>, &onSlot<1>, &onSlot<2>, &onSlot<3>
+};
+
+
+static void connect(unsigned int emitter, bool once)
+{
+    unsigned int receiver = random(Receivers);
+    unsigned int slot = random(Slots);
+
+    if (find(emitter, receiver, slot) < 0) {
+        if (sLive == MaxConnections ||
+                sOrderCount[emitter] == MaxPerEmitter) {
+            return;
+        }
+
+        uint16_t index = sFree[--sFreeCount];
+        Connection &connection = sConnections[index];
+
+        connection.serial = ++sSerial;
+        connection.emitter = emitter;
+        connection.receiver = receiver;
+        connection.slot = slot;
+        connection.once = once;
+        connection.alive = true;
+        sOrder[emitter][sOrderCount[emitter]++] = index;
+        sLive++;
+    }
+
+    if (once) {
+        sEmitters[emitter].once(&sReceivers[receiver], sSlots[slot]);
+    } else {
+        sEmitters[emitter].connect(&sReceivers[receiver], sSlots[slot]);
+    }
+}
+
+
+static void disconnect(unsigned int emitter)
+{
+    unsigned char count = sOrderCount[emitter];
+
+    if (count == 0) {
+        return;
+    }
+
+    const Connection &connection =
+        sConnections[sOrder[emitter][random(count)]];
+    unsigned int receiver = connection.receiver;
+    unsigned int slot = connection.slot;
+
+    forget(emitter, find(emitter, receiver, slot));
+    sEmitters[emitter].disconnect(&sReceivers[receiver], sSlots[slot]);
+}
+
+
+static void disconnectWildcard(unsigned int emitter)
+{
+    bool byReceiver = random(2) == 0;
+    unsigned int receiver = random(Receivers);
+    unsigned int slot = random(Slots);
+
+    for (unsigned char i = sOrderCount[emitter]; i-- > 0;) {
+        const Connection &connection = sConnections[sOrder[emitter][i]];
+
+        if (byReceiver ? connection.receiver == receiver :
+                connection.slot == slot) {
+            forget(emitter, i);
+        }
+    }
+
+    if (byReceiver) {
+        sEmitters[emitter].disconnect(&sReceivers[receiver], nullptr);
+    } else {
+        sEmitters[emitter].disconnect(nullptr, sSlots[slot]);
+    }
+}
+
+
+static void post(unsigned int emitter)
+{
+    if (!sPosted[emitter]) {
+        unsigned char priority = sEmitters[emitter].priority();
+
+        sPosted[emitter] = true;
+        sQueues[priority][sQueued[priority]++] = emitter;
+    }
+
+    sEmitters[emitter].post();
+}
+
+
+static void exec()
+{
+    sDispatchCount = 0;
+    sDispatched = 0;
+
+    for (unsigned char p = 0; p < EventEmitter::PrioritiesCount; p++) {
+        for (unsigned int i = 0; i < sQueued[p]; i++) {
+            sDispatch[sDispatchCount++] = sQueues[p][i];
+        }
+
+        sQueued[p] = 0;
+    }
+
+    sInExec = true;
+    Application::instance()->exec();
+    close(0);
+    sInExec = false;
+
+    if (sDispatched != sDispatchCount) {
+        fail("posted emitter not dispatched", sDispatch[sDispatched]);
+    }
+}
+
+
+static void operate(unsigned int depth)
+{
+    unsigned int emitter = random(sEmittersCount);
+    unsigned int choice = random(100);
+
+    sOperations++;
+
+    /* Lean towards disconnecting as the connections fill up */
+
+    if (choice < 25 && sLive > MaxConnections * 3 / 4) {
+        choice += 25;
+    }
+
+    if (choice < 25) {
+        connect(emitter, false);
+    } else if (choice < 35) {
+        connect(emitter, true);
+    } else if (choice < 55) {
+        disconnect(emitter);
+    } else if (choice < 60) {
+        disconnectWildcard(emitter);
+    } else if (choice < 75) {
+        post(emitter);
+    } else if (choice < 95 || depth > 0) {
+        sEmitters[emitter].emit();
+    } else {
+        exec();
+    }
+
+    if (depth == 0) {
+        close(0);
+
+        if (EventEmitter::connections() != sLive + sEmittersCount) {
+            fail("index out of step with the connections", emitter);
+        }
+    }
+}
+
+
+static double seconds()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+
+int main(int argc, char **argv)
+{
+    unsigned int seed = 1;
+    int option;
+
+    while ((option = getopt(argc, argv, "n:e:s:")) != -1) {
+        switch (option) {
+        case 'n':
+            sLimit = strtoul(optarg, nullptr, 10);
+            break;
+
+        case 'e':
+            sEmittersCount = strtoul(optarg, nullptr, 10);
+            break;
+
+        case 's':
+            seed = strtoul(optarg, nullptr, 10);
+            break;
+
+        default:
+            fprintf(stderr, "usage: %s [-n operations] [-e emitters] "
+                    "[-s seed]\n", argv[0]);
+
+            return 2;
+        }
+    }
+
+    if (sEmittersCount == 0 || sEmittersCount > MaxEmitters) {
+        fprintf(stderr, "churn: 1 to %u emitters\n", MaxEmitters);
+
+        return 2;
+    }
+
+    srand(seed);
+    Memory::begin();
+    HostBoard::reset();
+    Serial.setEcho(nullptr);
+
+    size_t baseline = Memory::live();
+
+    for (unsigned int i = 0; i < MaxConnections; i++) {
+        sFree[sFreeCount++] = MaxConnections - 1 - i;
+    }
+
+    for (unsigned int i = 0; i < sEmittersCount; i++) {
+        sEmitters[i].setPriority((EventEmitter::Priority)
+                random(EventEmitter::PrioritiesCount));
+        sEmitters[i].connect(&sProbe, &onProbe);
+    }
+
+    double start = seconds();
+
+    while (sOperations < sLimit) {
+        operate(0);
+    }
+
+    exec();
+
+    double elapsed = seconds() - start;
+    size_t peak = Memory::livePeak() - baseline;
+
+    for (unsigned int i = 0; i < sEmittersCount; i++) {
+        sEmitters[i].disconnect(nullptr, nullptr);
+    }
+
+    if (EventEmitter::connections() != 0) {
+        fail("connections left in the index", 0);
+    }
+
+    if (Memory::live() != baseline) {
+        fail("receiver nodes leaked", 0);
+    }
+
+    printf("churn: %lu operations (%lu emissions, %lu calls) in %.2f s, "
+            "%.0f ops/s\n", sOperations, sEmissions, sCalls, elapsed,
+            sOperations / elapsed);
+    printf("churn: peak %lu bytes in %u emitters, %u connections at the "
+            "end, %lu errors\n", (unsigned long) peak, sEmittersCount,
+            sLive + sEmittersCount, sErrors);
+
+    return sErrors == 0 ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+/*
+ * Sensor node stand-in. Streams synthetic RangesFrames at the rate of
+ * BreadthSensors::ready without waiting for answers, the way Link does,
+ * and reports the latency of the DirectionFrames that acknowledge them.
+ *
+ *     node [-p period_ms] [-n frames] device [baud]
+ */
+
+#include <math.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "LinkProtocol.hpp"
+#include "Tty.hpp"
+
+
+/* Same as Link::Window */
+static const unsigned char Window = 8;
+
+
+static unsigned long micros()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec * 1000000UL + now.tv_nsec / 1000;
+}
+
+
+static void send(int fd, uint8_t seq, unsigned long time)
+{
+    uint8_t payload[LinkProtocol::MaxPayload];
+    uint8_t frame[LinkProtocol::MaxFrame];
+    const uint8_t count = 5;
+    float phase = seq * 0.1f;
+
+    LinkProtocol::put32(payload, time);
+    payload[4] = count;
+
+    for (uint8_t i = 0; i < count; i++) {
+        LinkProtocol::put16(payload + 5 + i * 3,
+                350 + 300 * sinf(phase + i));
+        payload[7 + i * 3] = 0;
+    }
+
+    uint8_t length = LinkProtocol::encode(LinkProtocol::RangesFrame, seq,
+            payload, 5 + count * 3, frame);
+
+    if (write(fd, frame, length) != length) {
+        perror("write");
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    unsigned long period = 20;
+    unsigned long frames = 500;
+    int option;
+
+    while ((option = getopt(argc, argv, "p:n:")) != -1) {
+        switch (option) {
+        case 'p':
+            period = strtoul(optarg, nullptr, 10);
+            break;
+
+        case 'n':
+            frames = strtoul(optarg, nullptr, 10);
+            break;
+
+        default:
+            optind = argc;
+            break;
+        }
+    }
+
+    if (optind >= argc) {
+        fprintf(stderr, "usage: %s [-p period_ms] [-n frames] device [baud]\n",
+                argv[0]);
+
+        return 2;
+    }
+
+    int fd = openTty(argv[optind], optind + 1 < argc ?
+            strtoul(argv[optind + 1], nullptr, 10) : 115200);
+
+    if (fd < 0) {
+        return 1;
+    }
+
+    LinkProtocol::Decoder decoder;
+    unsigned long sentAt[Window];
+    unsigned long acked = 0;
+    unsigned long stale = 0;
+    unsigned long total = 0;
+    unsigned long worst = 0;
+    unsigned long next = micros();
+    unsigned long sent = 0;
+    uint8_t seq = 0;
+    struct pollfd pfd = { fd, POLLIN, 0 };
+
+    while (sent < frames || micros() - next < 500000) {
+        unsigned long now = micros();
+
+        if (sent < frames && (long) (now - next) >= 0) {
+            send(fd, seq, now);
+            sentAt[seq % Window] = now;
+            seq++;
+            sent++;
+            next += period * 1000;
+        }
+
+        if (poll(&pfd, 1, 1) <= 0) {
+            continue;
+        }
+
+        uint8_t buffer[64];
+        ssize_t size = read(fd, buffer, sizeof(buffer));
+
+        for (ssize_t i = 0; i < size; i++) {
+            if (!decoder.feed(buffer[i]) ||
+                    decoder.type() != LinkProtocol::DirectionFrame ||
+                    decoder.length() != LinkProtocol::DirectionLength) {
+                continue;
+            }
+
+            uint8_t ack = decoder.payload()[0];
+            uint8_t age = seq - ack;
+
+            if (age == 0 || age > Window) {
+                stale++;
+
+                continue;
+            }
+
+            unsigned long latency = micros() - sentAt[ack % Window];
+
+            acked++;
+            total += latency;
+
+            if (latency > worst) {
+                worst = latency;
+            }
+        }
+    }
+
+    printf("node: sent %lu, acked %lu, stale %lu, errors %lu, "
+            "latency mean %lu us, worst %lu us\n",
+            sent, acked, stale, decoder.errors(),
+            acked != 0 ? total / acked : 0, worst);
+
+    return acked == 0;
+}
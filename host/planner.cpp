@@ -0,0 +1,154 @@
+/*
+ * Planner node stand-in. Decodes RangesFrames from the sensor node and
+ * answers each with a DirectionFrame acknowledging its seq. The planner
+ * itself only steers away from the nearer front corner and slows down in
+ * front of obstacles; it is the place to try heavier planning off-board.
+ *
+ *     planner [-d delay_ms] [device [baud]]
+ *
+ * Without a device a pty is created and its slave path printed.
+ */
+
+#include <math.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "LinkProtocol.hpp"
+#include "Tty.hpp"
+
+
+/* VL53L0XAsync::maximum() of the HighSpeed profile */
+static const float Maximum = 700;
+
+
+static float rangeAt(const uint8_t *payload, uint8_t count, uint8_t index)
+{
+    if (index >= count) {
+        return Maximum;
+    }
+
+    const uint8_t *range = payload + 5 + index * 3;
+    uint16_t value = LinkProtocol::get16(range);
+
+    /* Anything but RangeSensor::RangeValid reads as free space */
+
+    if (range[2] != 0 || value > Maximum) {
+        return Maximum;
+    }
+
+    return value;
+}
+
+
+static void plan(const uint8_t *payload, uint8_t length, float *x, float *y)
+{
+    uint8_t count = payload[4];
+
+    if (length < 5 + count * 3) {
+        count = 0;
+    }
+
+    float front = rangeAt(payload, count, 0);
+    float left = rangeAt(payload, count, 1);
+    float right = rangeAt(payload, count, 2);
+
+    /* Drive on x, steer on y towards the roomier side, left positive */
+
+    *x = front / Maximum;
+    *y = (left - right) / Maximum;
+
+    float magnitude = sqrtf(*x * *x + *y * *y);
+
+    if (magnitude > 1) {
+        *x /= magnitude;
+        *y /= magnitude;
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    unsigned long delay = 0;
+    int option;
+
+    while ((option = getopt(argc, argv, "d:")) != -1) {
+        if (option != 'd') {
+            fprintf(stderr, "usage: %s [-d delay_ms] [device [baud]]\n",
+                    argv[0]);
+
+            return 2;
+        }
+
+        delay = strtoul(optarg, nullptr, 10);
+    }
+
+    int fd = optind < argc ?
+        openTty(argv[optind], optind + 1 < argc ?
+                strtoul(argv[optind + 1], nullptr, 10) : 115200) :
+        openPty();
+
+    if (fd < 0) {
+        return 1;
+    }
+
+    LinkProtocol::Decoder decoder;
+    uint8_t seq = 0;
+    struct pollfd pfd = { fd, POLLIN, 0 };
+
+    for (;;) {
+        uint8_t buffer[64];
+
+        if (poll(&pfd, 1, 1000) <= 0) {
+            continue;
+        }
+
+        ssize_t size = read(fd, buffer, sizeof(buffer));
+
+        if (size <= 0) {
+            usleep(10000);
+
+            continue;
+        }
+
+        for (ssize_t i = 0; i < size; i++) {
+            if (!decoder.feed(buffer[i]) ||
+                    decoder.type() != LinkProtocol::RangesFrame) {
+                continue;
+            }
+
+            float x;
+            float y;
+            uint8_t payload[LinkProtocol::DirectionLength];
+            uint8_t frame[LinkProtocol::MaxFrame];
+
+            plan(decoder.payload(), decoder.length(), &x, &y);
+
+            if (delay != 0) {
+                usleep(delay * 1000);
+            }
+
+            payload[0] = decoder.seq();
+            LinkProtocol::put16(payload + 1,
+                    lrintf(x * LinkProtocol::DirectionScale));
+            LinkProtocol::put16(payload + 3,
+                    lrintf(y * LinkProtocol::DirectionScale));
+            LinkProtocol::put16(payload + 5, 0);
+
+            uint8_t length = LinkProtocol::encode(LinkProtocol::DirectionFrame,
+                    seq++, payload, sizeof(payload), frame);
+
+            if (write(fd, frame, length) != length) {
+                perror("write");
+            }
+
+            if (decoder.frames() % 50 == 0) {
+                printf("planner: frames %lu, errors %lu, direction %.2f %.2f\n",
+                        decoder.frames(), decoder.errors(), x, y);
+                fflush(stdout);
+            }
+        }
+    }
+}
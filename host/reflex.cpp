@@ -0,0 +1,249 @@
+/*
+ * Time the safe-stop reflex on the host board. A forward driving
+ * RickshawController gets an obstacle dropped in front of it at a
+ * different phase of the sensor period in every trial; the latency is
+ * from that moment to the motor PWM reaching 0. The same is measured
+ * with the stop left to a planner on BreadthSensors::ready, with and
+ * without the old one second delay in loop().
+ *
+ *     reflex [-n trials]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "Application.hpp"
+#include "BreadthSensors.hpp"
+#include "HostBoard.hpp"
+#include "RickshawController.hpp"
+#include "SafeStop.hpp"
+#include "Timer.hpp"
+
+
+static const unsigned char PwmPin = 5;
+static const unsigned long SamplePeriod = 20;
+static const unsigned long LoopCost = 300;
+static const uint16_t StopDistance = 120;
+static const uint16_t FarDistance = 2000;
+
+
+/* Ranges whatever distance() says, one sample per period */
+class ScriptedSensor : public RangeSensor
+{
+
+    EVENT_OBJECT_SLOT(ScriptedSensor, onTimerExpired);
+
+
+    Timer mTimer;
+    uint16_t mDistance;
+
+
+public:
+
+    explicit ScriptedSensor()
+        : RangeSensor(),
+        mTimer(SamplePeriod),
+        mDistance(FarDistance)
+    {
+        EventObjectConnect(&mTimer, expired, this, onTimerExpired);
+    }
+
+
+    virtual void start() override
+    {
+        mTimer.start();
+    }
+
+
+    virtual void reinit() override
+    {
+        initFinished()->post();
+    }
+
+
+    virtual uint16_t delta() const override
+    {
+        return 40;
+    }
+
+
+    virtual uint16_t maximum() const override
+    {
+        return 700;
+    }
+
+
+    virtual uint16_t signalRate() const override
+    {
+        return 0;
+    }
+
+
+    virtual uint16_t ambientRate() const override
+    {
+        return 0;
+    }
+
+
+    virtual void setPower(unsigned char) override
+    {
+
+    }
+
+
+    virtual unsigned char power() const override
+    {
+        return PowerActive;
+    }
+
+
+    inline void setDistance(uint16_t value)
+    {
+        mDistance = value;
+    }
+
+
+};
+
+
+void ScriptedSensor::onTimerExpired()
+{
+    writeSample(mDistance, RangeValid);
+    rangeReady()->post();
+}
+
+
+static RickshawController *sController;
+static BreadthSensors *sSensors;
+static bool sPlannerStops;
+static unsigned long sCutTime;
+
+
+static void onAnalogWrite(uint8_t pin, int value)
+{
+    if (pin == PwmPin && value == 0 && sCutTime == 0) {
+        sCutTime = HostBoard::time();
+    }
+}
+
+
+static void onSensorsReady(EventObject *)
+{
+    if (sPlannerStops && sSensors->front() <= StopDistance) {
+        sController->setDirection(Vector2f(0, 0));
+    }
+}
+
+
+/* Spin loop() until the given time or, if untilCut, until the PWM is cut */
+static void run(unsigned long until, unsigned long loopDelay, bool untilCut)
+{
+    while ((long) (HostBoard::time() - until) < 0 &&
+            !(untilCut && sCutTime != 0)) {
+        Application::instance()->exec();
+        HostBoard::advance(LoopCost + loopDelay);
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    unsigned long trials = 50;
+    int option;
+
+    while ((option = getopt(argc, argv, "n:")) != -1) {
+        if (option != 'n') {
+            fprintf(stderr, "usage: %s [-n trials]\n", argv[0]);
+
+            return 2;
+        }
+
+        trials = strtoul(optarg, nullptr, 10);
+    }
+
+    HostBoard::reset();
+    Serial.setEcho(nullptr);
+
+    ScriptedSensor front;
+    ScriptedSensor left;
+    ScriptedSensor right;
+    BreadthSensors sensors(160, 250);
+    RickshawController controller(PwmPin, 7, 8, 4);
+    SafeStop safeStop(&controller);
+
+    sController = &controller;
+    sSensors = &sensors;
+
+    sensors.setSensor(BreadthSensors::Front, &front);
+    sensors.setSensor(BreadthSensors::FrontLeft, &left);
+    sensors.setSensor(BreadthSensors::FrontRight, &right);
+    sensors.ready()->connect(nullptr, &onSensorsReady);
+    safeStop.addSensor(&front, MovementController::InhibitForward,
+            StopDistance);
+
+    HostBoard::setAnalogListener(&onAnalogWrite);
+    Application::instance()->started()->emit();
+
+    /* Out of phase, as sensors that finished their init at different times */
+
+    front.reinit();
+    run(HostBoard::time() + SamplePeriod * 1000 / 3, 0, false);
+    left.reinit();
+    run(HostBoard::time() + SamplePeriod * 1000 / 3, 0, false);
+    right.reinit();
+
+    static const struct
+    {
+        const char *name;
+        bool reflex;
+        unsigned long loopDelay;
+    } paths[] = {
+        { "reflex", true, 0 },
+        { "planner", false, 0 },
+        { "planner, delay(1000)", false, 1000000 }
+    };
+
+    printf("%-22s %10s %10s %10s  (us from obstacle to PWM 0)\n",
+            "path", "min", "mean", "max");
+
+    for (unsigned char p = 0; p < sizeof(paths) / sizeof(paths[0]); p++) {
+        unsigned long worst = 0;
+        unsigned long best = (unsigned long) -1;
+        unsigned long total = 0;
+
+        front.setStopDistance(paths[p].reflex ? StopDistance : 0);
+        sPlannerStops = !paths[p].reflex;
+
+        for (unsigned long trial = 0; trial < trials; trial++) {
+
+            /* Clear the way, drive, then drop the obstacle mid-period */
+
+            front.setDistance(FarDistance);
+            run(HostBoard::time() + 5 * SamplePeriod * 1000, 0, false);
+
+            controller.setDirection(Vector2f(0.8, 0));
+            run(HostBoard::time() + trial * SamplePeriod * 1000 / trials, 0,
+                    false);
+
+            unsigned long appeared = HostBoard::time();
+
+            front.setDistance(StopDistance / 2);
+            sCutTime = 0;
+            run(appeared + 10000000, paths[p].loopDelay, true);
+
+            unsigned long latency = sCutTime - appeared;
+
+            total += latency;
+            worst = latency > worst ? latency : worst;
+            best = latency < best ? latency : best;
+        }
+
+        printf("%-22s %10lu %10lu %10lu\n", paths[p].name, best,
+                total / trials, worst);
+    }
+
+    printf("safe stop triggered %lu times\n", safeStop.triggers());
+
+    return 0;
+}
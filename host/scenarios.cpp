@@ -0,0 +1,443 @@
+/*
+ * Score the robot on scripted courses in the closed loop host simulation:
+ * BreadthSensors -> BasicMovementHeuristics -> RickshawController on the
+ * simulated rickshaw and sensors. Every scenario runs in its own process
+ * from a fresh HostBoard, so results do not depend on the order or on
+ * which scenarios are picked. For each one the suite reports
+ *
+ *  - whether it completed and when: the goal line was crossed or, in a
+ *    dead end, the robot came to rest before the end wall;
+ *  - the distance travelled and the mean speed up to then;
+ *  - the minimum clearance between body and walls, and collisions;
+ *  - how far Robot's odometry ended up from the true pose of the rear
+ *    axle, in mm and degrees;
+ *  - host cycles spent in the firmware per control step, a control step
+ *    being one BreadthSensors::ready.
+ *
+ * Everything but the cycles is a function of the seed. -j writes the
+ * same as JSON ("-" for stdout) for comparing runs. The exit status is
+ * non-zero when a scenario failed, collided or its odometry drifted by
+ * more than OdometryTolerance of the distance or HeadingTolerance.
+ *
+ *     scenarios [-s seed] [-j summary.json] [scenario ...]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "HostBoard.hpp"
+#include "Simulation.hpp"
+
+
+static const unsigned long CheckPeriod = 10000;     /* us */
+static const unsigned long RestTime = 1000000;      /* us */
+static const float RestSpeed = 5;                   /* mm/s */
+
+/* Odometry drift allowed, per mm travelled and in degrees */
+static const float OdometryTolerance = 0.05;
+static const float HeadingTolerance = 10;
+
+
+struct Scenario
+{
+    const char *name;
+    void (*build)(World *world);
+    float x;
+    float y;
+    float heading;
+
+    /* Goal line to cross, or NAN to come to rest past restX instead */
+    float goalX;
+    float restX;
+
+    float timeout;      /* s */
+};
+
+
+struct Result
+{
+    bool completed;
+    float time;             /* s */
+    float distance;         /* mm */
+    float meanSpeed;        /* mm/s */
+    float minimumClearance; /* mm */
+    unsigned long collisions;
+    float odometryError;    /* mm off the rear axle's true position */
+    float headingError;     /* degrees */
+    unsigned long steps;
+    double cyclesPerStep;
+};
+
+
+/* Closed at the start, 800 mm wide, open at the end */
+static void buildCorridor(World *world)
+{
+    Vector2f walls[] = {
+        Vector2f(6000, 0),
+        Vector2f(0, 0),
+        Vector2f(0, 800),
+        Vector2f(6000, 800)
+    };
+
+    world->addPolygon(walls, 4, true);
+}
+
+
+/* Two 45 degree jogs of a metre each, 1200 mm wide at the straights */
+static void buildSBend(World *world)
+{
+    Vector2f lower[] = {
+        Vector2f(0, 0),
+        Vector2f(2000, 0),
+        Vector2f(3000, 1000),
+        Vector2f(4000, 1000),
+        Vector2f(5000, 0),
+        Vector2f(7000, 0)
+    };
+    Vector2f upper[6];
+    Vector2f back[] = { Vector2f(0, 0), Vector2f(0, 1200) };
+
+    for (unsigned char i = 0; i < 6; i++) {
+        upper[i] = lower[i] + Vector2f(0, 1200);
+    }
+
+    world->addPolygon(lower, 6, true);
+    world->addPolygon(upper, 6, true);
+    world->addPolygon(back, 2, true);
+}
+
+
+/* 1 m wide and closed 3 m in */
+static void buildDeadEnd(World *world)
+{
+    Vector2f walls[] = {
+        Vector2f(0, 1000),
+        Vector2f(3000, 1000),
+        Vector2f(3000, 0),
+        Vector2f(0, 0)
+    };
+
+    world->addPolygon(walls, 4);
+}
+
+
+/* Two rooms joined by a 600 mm door, off the line the robot starts on */
+static void buildDoorway(World *world)
+{
+    Vector2f walls[] = {
+        Vector2f(4500, 3000),
+        Vector2f(0, 3000),
+        Vector2f(0, 0),
+        Vector2f(4500, 0)
+    };
+    Vector2f below[] = { Vector2f(2000, 0), Vector2f(2000, 1450) };
+    Vector2f above[] = { Vector2f(2000, 2050), Vector2f(2000, 3000) };
+
+    world->addPolygon(walls, 4, true);
+    world->addPolygon(below, 2, true);
+    world->addPolygon(above, 2, true);
+}
+
+
+/*
+ * The corridor, 1200 mm wide, with a side passage that a box crosses
+ * about when the robot gets there
+ */
+static void buildMovingObstacle(World *world)
+{
+    Vector2f lower[] = {
+        Vector2f(6000, 0),
+        Vector2f(3400, 0)
+    };
+    Vector2f lowerStart[] = {
+        Vector2f(2800, 0),
+        Vector2f(0, 0),
+        Vector2f(0, 1200),
+        Vector2f(2800, 1200)
+    };
+    Vector2f upper[] = {
+        Vector2f(3400, 1200),
+        Vector2f(6000, 1200)
+    };
+
+    world->addPolygon(lower, 2, true);
+    world->addPolygon(lowerStart, 4, true);
+    world->addPolygon(upper, 2, true);
+    world->addBox(2950, -1700, 300, 300, Vector2f(0, 150));
+}
+
+
+static const Scenario Scenarios[] = {
+    { "corridor", &buildCorridor, 600, 400, 0, 5500, NAN, 90 },
+    { "s-bend", &buildSBend, 600, 600, 0, 6500, NAN, 120 },
+    { "dead-end", &buildDeadEnd, 600, 500, 0, NAN, 2000, 60 },
+    { "doorway", &buildDoorway, 600, 1500, 0, 3000, NAN, 90 },
+    { "moving-obstacle", &buildMovingObstacle, 600, 600, 0, 5500, NAN, 120 }
+};
+
+static const unsigned char ScenariosCount =
+    sizeof(Scenarios) / sizeof(Scenarios[0]);
+
+
+static unsigned long sSteps;
+
+
+static void onControlStep(EventObject *)
+{
+    sSteps++;
+}
+
+
+static Result run(const Scenario &scenario, unsigned long seed)
+{
+    HostBoard::reset();
+    Serial.setEcho(nullptr);
+
+    static World world;
+
+    scenario.build(&world);
+
+    static Simulation simulation(&world,
+            Vector2f(scenario.x, scenario.y), scenario.heading, seed);
+    RickshawModel &vehicle = simulation.vehicle();
+    Vector2f rearAxle(-Robot::WheelBase / 2, 0);
+    Vector2f origin = vehicle.toWorld(rearAxle);
+    float originHeading = vehicle.heading();
+    unsigned long start = HostBoard::time();
+    unsigned long end = start + scenario.timeout * 1e6;
+    unsigned long restingSince = start;
+    Result result = Result();
+
+    simulation.robot().breadthSensors().ready()->connect(nullptr,
+            &onControlStep);
+    simulation.begin();
+
+    while ((long) (HostBoard::time() - end) < 0) {
+        simulation.run(HostBoard::time() + CheckPeriod);
+
+        float x = vehicle.position().x();
+
+        if (!isnan(scenario.goalX) && x >= scenario.goalX) {
+            result.completed = true;
+            result.time = (HostBoard::time() - start) / 1e6;
+
+            break;
+        }
+
+        if (fabsf(vehicle.speed()) > RestSpeed || isnan(scenario.restX) ||
+                x < scenario.restX) {
+            restingSince = HostBoard::time();
+        } else if (HostBoard::time() - restingSince >= RestTime) {
+            result.completed = true;
+            result.time = (restingSince - start) / 1e6;
+
+            break;
+        }
+    }
+
+    if (!result.completed) {
+        result.time = scenario.timeout;
+    }
+
+    result.distance = vehicle.distance();
+    result.meanSpeed = result.distance / result.time;
+    result.minimumClearance = simulation.minimumClearance();
+    result.collisions = simulation.collisions();
+
+    /* Odometry against the truth, both in the frame the robot started in */
+
+    const Pose &pose = simulation.robot().odometry().pose();
+    Vector2f moved = vehicle.toWorld(rearAxle) - origin;
+    float c = cosf(originHeading);
+    float s = sinf(originHeading);
+    Vector2f truth(moved.x() * c + moved.y() * s,
+            moved.y() * c - moved.x() * s);
+    Vector2f error = Vector2f(pose.x / 256.0f, pose.y / 256.0f) - truth;
+    float turn = remainderf(pose.heading * (float) (2 * M_PI / 65536) -
+            (vehicle.heading() - originHeading), 2 * M_PI);
+
+    result.odometryError = sqrtf(error.sqrMagnitude());
+    result.headingError = fabsf(turn) * (float) (180 / M_PI);
+    result.steps = sSteps;
+    result.cyclesPerStep = sSteps == 0 ? 0 :
+        (double) simulation.firmwareCycles() / sSteps;
+
+    return result;
+}
+
+
+/* Run the scenario in a child, which owns the board and the bus */
+static bool runForked(const Scenario &scenario, unsigned long seed,
+        Result *result)
+{
+    int fds[2];
+
+    if (pipe(fds) != 0) {
+        perror("pipe");
+
+        return false;
+    }
+
+    pid_t pid = fork();
+
+    if (pid < 0) {
+        perror("fork");
+
+        return false;
+    }
+
+    if (pid == 0) {
+        Result value = run(scenario, seed);
+
+        close(fds[0]);
+        _exit(write(fds[1], &value, sizeof(value)) == sizeof(value) ? 0 : 1);
+    }
+
+    close(fds[1]);
+
+    bool ok = read(fds[0], result, sizeof(*result)) == sizeof(*result);
+    int status;
+
+    close(fds[0]);
+    waitpid(pid, &status, 0);
+
+    return ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+
+static void writeJson(FILE *file, unsigned long seed,
+        const Scenario **scenarios, const Result *results,
+        unsigned char count)
+{
+    unsigned char completed = 0;
+    unsigned long collisions = 0;
+    float time = 0;
+
+    fprintf(file, "{\"seed\":%lu,\"scenarios\":[", seed);
+
+    for (unsigned char i = 0; i < count; i++) {
+        const Result &result = results[i];
+
+        completed += result.completed;
+        collisions += result.collisions;
+        time += result.time;
+
+        fprintf(file, "%s\n{\"name\":\"%s\",\"completed\":%s,"
+                "\"time\":%.3f,\"distance\":%.0f,\"meanSpeed\":%.1f,"
+                "\"minimumClearance\":%.1f,\"collisions\":%lu,"
+                "\"odometryError\":%.1f,\"headingError\":%.2f,"
+                "\"controlSteps\":%lu,\"cyclesPerStep\":%.0f}",
+                i == 0 ? "" : ",", scenarios[i]->name,
+                result.completed ? "true" : "false", result.time,
+                result.distance, result.meanSpeed, result.minimumClearance,
+                result.collisions, result.odometryError, result.headingError,
+                result.steps, result.cyclesPerStep);
+    }
+
+    fprintf(file, "\n],\"completed\":%u,\"collisions\":%lu,"
+            "\"totalTime\":%.3f}\n", completed, collisions, time);
+}
+
+
+int main(int argc, char **argv)
+{
+    unsigned long seed = 1;
+    const char *jsonPath = nullptr;
+    int option;
+
+    while ((option = getopt(argc, argv, "s:j:")) != -1) {
+        switch (option) {
+        case 's':
+            seed = strtoul(optarg, nullptr, 10);
+            break;
+
+        case 'j':
+            jsonPath = optarg;
+            break;
+
+        default:
+            fprintf(stderr, "usage: %s [-s seed] [-j summary.json] "
+                    "[scenario ...]\n", argv[0]);
+
+            return 2;
+        }
+    }
+
+    const Scenario *picked[ScenariosCount];
+    unsigned char count = 0;
+
+    if (optind == argc) {
+        for (unsigned char i = 0; i < ScenariosCount; i++) {
+            picked[count++] = &Scenarios[i];
+        }
+    }
+
+    for (int arg = optind; arg < argc; arg++) {
+        unsigned char i = 0;
+
+        while (i < ScenariosCount && strcmp(Scenarios[i].name, argv[arg])) {
+            i++;
+        }
+
+        if (i == ScenariosCount) {
+            fprintf(stderr, "%s: no scenario %s\n", argv[0], argv[arg]);
+
+            return 2;
+        }
+
+        if (count < ScenariosCount) {
+            picked[count++] = &Scenarios[i];
+        }
+    }
+
+    Result results[ScenariosCount];
+    bool passed = true;
+
+    printf("%-16s %9s %8s %8s %9s %9s %6s %7s %7s %11s\n", "scenario",
+            "result", "time s", "dist mm", "mm/s", "clear mm", "hits",
+            "odo mm", "odo deg", "cycles/step");
+
+    for (unsigned char i = 0; i < count; i++) {
+        Result &result = results[i];
+
+        if (!runForked(*picked[i], seed, &result)) {
+            fprintf(stderr, "%s: %s crashed\n", argv[0], picked[i]->name);
+
+            return 1;
+        }
+
+        passed = passed && result.completed && result.collisions == 0 &&
+            result.odometryError <= result.distance * OdometryTolerance &&
+            result.headingError <= HeadingTolerance;
+
+        printf("%-16s %9s %8.2f %8.0f %9.1f %9.1f %6lu %7.0f %7.1f %11.0f\n",
+                picked[i]->name, result.completed ? "completed" : "timeout",
+                result.time, result.distance, result.meanSpeed,
+                result.minimumClearance, result.collisions,
+                result.odometryError, result.headingError,
+                result.cyclesPerStep);
+    }
+
+    if (jsonPath != nullptr) {
+        FILE *file = strcmp(jsonPath, "-") == 0 ? stdout :
+            fopen(jsonPath, "w");
+
+        if (file == nullptr) {
+            perror(jsonPath);
+
+            return 1;
+        }
+
+        writeJson(file, seed, picked, results, count);
+
+        if (file != stdout) {
+            fclose(file);
+        }
+    }
+
+    return passed ? 0 : 1;
+}
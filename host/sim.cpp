@@ -0,0 +1,147 @@
+/*
+ * Run the whole Robot closed loop in a room on the host: the rickshaw
+ * follows its own pins and the VL53L0XAsync sensors talk to simulated
+ * ones over the host I2C bus. Prints how far it got and how close it
+ * came to the walls; -o writes the trajectory as CSV, one row per
+ * TracePeriod of simulated time.
+ *
+ *     sim [-t seconds] [-s seed] [-o trace.csv]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "HostBoard.hpp"
+#include "Simulation.hpp"
+
+
+static const unsigned long TracePeriod = 20000;
+
+
+static double seconds()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+
+/* 5 x 3 m with a table and a pillar; the robot starts at the west wall */
+static void buildRoom(World *world)
+{
+    Vector2f walls[] = {
+        Vector2f(0, 0),
+        Vector2f(5000, 0),
+        Vector2f(5000, 3000),
+        Vector2f(0, 3000)
+    };
+
+    world->addPolygon(walls, 4);
+    world->addBox(2000, 1800, 1200, 700);
+    world->addBox(3600, 700, 250, 250);
+}
+
+
+static void trace(FILE *file, Simulation &simulation)
+{
+    const RickshawModel &vehicle = simulation.vehicle();
+    BreadthSensors &sensors = simulation.robot().breadthSensors();
+
+    fprintf(file, "%.3f,%.1f,%.1f,%.4f,%.1f,%.4f,%.0f,%.0f,%.0f,%.1f\n",
+            HostBoard::time() / 1e6, vehicle.position().x(),
+            vehicle.position().y(), vehicle.heading(), vehicle.speed(),
+            vehicle.steering(), sensors.front(), sensors.frontLeft(),
+            sensors.frontRight(), simulation.clearance());
+}
+
+
+int main(int argc, char **argv)
+{
+    float duration = 60;
+    unsigned long seed = 1;
+    const char *tracePath = nullptr;
+    int option;
+
+    while ((option = getopt(argc, argv, "t:s:o:")) != -1) {
+        switch (option) {
+        case 't':
+            duration = strtof(optarg, nullptr);
+            break;
+
+        case 's':
+            seed = strtoul(optarg, nullptr, 10);
+            break;
+
+        case 'o':
+            tracePath = optarg;
+            break;
+
+        default:
+            fprintf(stderr, "usage: %s [-t seconds] [-s seed] "
+                    "[-o trace.csv]\n", argv[0]);
+
+            return 2;
+        }
+    }
+
+    FILE *traceFile = nullptr;
+
+    if (tracePath != nullptr) {
+        traceFile = fopen(tracePath, "w");
+
+        if (traceFile == nullptr) {
+            perror(tracePath);
+
+            return 1;
+        }
+
+        fprintf(traceFile, "time,x,y,heading,speed,steering,"
+                "front,left,right,clearance\n");
+    }
+
+    HostBoard::reset();
+    Serial.setEcho(nullptr);
+
+    static World world;
+
+    buildRoom(&world);
+
+    static Simulation simulation(&world, Vector2f(400, 1500), 0, seed);
+    unsigned long end = HostBoard::time() + duration * 1e6;
+    double started = seconds();
+
+    simulation.begin();
+
+    while ((long) (HostBoard::time() - end) < 0) {
+        simulation.run(HostBoard::time() + TracePeriod);
+
+        if (traceFile != nullptr) {
+            trace(traceFile, simulation);
+        }
+    }
+
+    double wall = seconds() - started;
+    unsigned long samples = 0;
+
+    for (unsigned char i = 0; i < Robot::SensorsCount; i++) {
+        samples += simulation.tof(i).measurements();
+    }
+
+    if (traceFile != nullptr) {
+        fclose(traceFile);
+    }
+
+    printf("simulated %.1f s in %.2f s (%.0fx real time), %lu loops\n",
+            duration, wall, duration / wall, simulation.loops());
+    printf("travelled %.0f mm, %lu collisions, minimum clearance %.0f mm\n",
+            simulation.vehicle().distance(), simulation.collisions(),
+            simulation.minimumClearance());
+    printf("%lu sensor measurements\n", samples);
+
+    return 0;
+}
@@ -0,0 +1,193 @@
+/*
+ * Convert a Trace::dump() captured from the serial port into the Chrome
+ * trace event format, loadable by chrome://tracing and Perfetto.
+ *
+ *     trace2json [-s symbols] < dump.txt > trace.json
+ *
+ * symbols is the output of nm (e.g. avr-nm -C dlar.elf); ids matching a
+ * symbol address, or half of one for AVR word addressed functions, are
+ * named after it. Lines outside "trace" ... "trace end" are ignored, so
+ * a raw serial log can be fed in as is.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <map>
+#include <string>
+
+
+static std::map<uint16_t, std::string> sSymbols;
+
+
+static void loadSymbols(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    char line[512];
+
+    if (file == nullptr) {
+        perror(path);
+        exit(1);
+    }
+
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        unsigned long address;
+        char type;
+        int offset;
+
+        if (sscanf(line, "%lx %c %n", &address, &type, &offset) != 2) {
+            continue;
+        }
+
+        std::string name(line + offset);
+
+        name.erase(name.find_last_not_of("\r\n") + 1);
+        sSymbols.insert(std::make_pair((uint16_t) address, name));
+
+        if (type == 'T' || type == 't') {
+            sSymbols.insert(std::make_pair((uint16_t) (address >> 1), name));
+        }
+    }
+
+    fclose(file);
+}
+
+
+static std::string nameOf(const char *prefix, unsigned int id)
+{
+    std::map<uint16_t, std::string>::const_iterator symbol =
+        sSymbols.find(id);
+    std::string name(prefix);
+    char hex[8];
+
+    if (symbol != sSymbols.end()) {
+        return name + symbol->second;
+    }
+
+    snprintf(hex, sizeof(hex), "0x%04x", id);
+
+    return name + hex;
+}
+
+
+static void escape(std::string &value)
+{
+    for (size_t i = 0; i < value.size(); i++) {
+        if (value[i] == '"' || value[i] == '\\') {
+            value.insert(i++, 1, '\\');
+        }
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    int option;
+
+    while ((option = getopt(argc, argv, "s:")) != -1) {
+        if (option != 's') {
+            fprintf(stderr, "usage: %s [-s symbols] < dump > json\n", argv[0]);
+
+            return 2;
+        }
+
+        loadSymbols(optarg);
+    }
+
+    char line[128];
+    bool inside = false;
+    bool first = true;
+    unsigned long depth = 0;
+    uint32_t last = 0;
+    uint64_t epoch = 0;
+    bool started = false;
+
+    printf("{\"traceEvents\":[\n");
+
+    while (fgets(line, sizeof(line), stdin) != nullptr) {
+        char kind;
+        unsigned int id;
+        unsigned long time;
+
+        if (strncmp(line, "trace end", 9) == 0) {
+            inside = false;
+
+            continue;
+        }
+
+        if (strncmp(line, "trace ", 6) == 0) {
+            inside = true;
+            depth = 0;
+            started = false;
+
+            continue;
+        }
+
+        if (!inside || sscanf(line, "%c %x %lu", &kind, &id, &time) != 3) {
+            continue;
+        }
+
+        /* Unwrap the 32-bit micros() of consecutive records */
+
+        if (started && (uint32_t) time < last) {
+            epoch += (uint64_t) 1 << 32;
+        }
+
+        started = true;
+        last = time;
+
+        const char *phase = "i";
+        std::string name;
+
+        switch (kind) {
+        case 'B':
+            phase = "B";
+            name = nameOf("", id);
+            depth++;
+            break;
+
+        case 'X':
+
+            /* The ring may start inside a slot */
+
+            if (depth == 0) {
+                continue;
+            }
+
+            phase = "E";
+            name = nameOf("", id);
+            depth--;
+            break;
+
+        case 'E':
+            name = nameOf("emit ", id);
+            break;
+
+        case 'P':
+            name = nameOf("post ", id);
+            break;
+
+        case 'T':
+            name = nameOf("timer ", id);
+            break;
+
+        default:
+            continue;
+        }
+
+        escape(name);
+        printf("%s{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%llu,"
+                "\"pid\":0,\"tid\":0%s}",
+                first ? "" : ",\n", name.c_str(), phase,
+                (unsigned long long) (epoch + time),
+                phase[0] == 'i' ? ",\"s\":\"t\"" : "");
+        first = false;
+    }
+
+    printf("\n]}\n");
+
+    return 0;
+}